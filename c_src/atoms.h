@@ -65,6 +65,14 @@ extern ERL_NIF_TERM ATOM_KEYS_ONLY;
 extern ERL_NIF_TERM ATOM_COMPRESSION;
 extern ERL_NIF_TERM ATOM_ERROR_DB_REPAIR;
 extern ERL_NIF_TERM ATOM_USE_BLOOMFILTER;
+extern ERL_NIF_TERM ATOM_QUEUED;
+extern ERL_NIF_TERM ATOM_DBS;
+extern ERL_NIF_TERM ATOM_COUNTERS;
+extern ERL_NIF_TERM ATOM_INTERVAL_US;
+extern ERL_NIF_TERM ATOM_ELEVELDB_STATS;
+
+// keys of eleveldb:db_stats/1 and of the stats push, indexed by DbStats::CounterEnum
+extern ERL_NIF_TERM * const DB_COUNTER_ATOMS[];
 
 }   // namespace eleveldb
 
@@ -0,0 +1,1000 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef INCL_ERL_NIF_SHIM_H
+    #include "erl_nif_shim.h"
+#endif
+
+
+/**
+ * One term.  ERL_NIF_TERM is simply a pointer to one of these.
+ *  Atoms, pids and nil are immortal, everything else belongs to
+ *  the env that created it.
+ */
+struct ShimTerm
+{
+    enum Kind {eAtom, eInt, eDouble, eRef, ePid, eBinary, eTuple, eCons, eNil, eResource};
+
+    Kind m_Kind;
+    bool m_Immortal;
+    int64_t m_Int;                        //!< eInt, eRef and ePid id
+    double m_Double;
+    std::string m_Name;                   //!< eAtom
+    std::vector<ERL_NIF_TERM> m_Elems;    //!< eTuple elements, eCons head and tail
+    unsigned char * m_Data;               //!< eBinary, owned
+    size_t m_Size;
+    struct ShimResource * m_Resource;     //!< eResource, holds one reference
+
+    explicit ShimTerm(Kind TermKind)
+        : m_Kind(TermKind), m_Immortal(false), m_Int(0), m_Double(0.0),
+          m_Data(NULL), m_Size(0), m_Resource(NULL)
+    {};
+};  // struct ShimTerm
+
+
+struct ShimProcess
+{
+    ERL_NIF_TERM m_Pid;
+    pthread_mutex_t m_Mutex;
+    pthread_cond_t m_Cond;
+    std::deque<std::pair<ErlNifEnv *, ERL_NIF_TERM> > m_Mailbox;
+
+    ShimProcess() : m_Pid(0)
+    {
+        pthread_mutex_init(&m_Mutex, NULL);
+        pthread_cond_init(&m_Cond, NULL);
+    };
+};  // struct ShimProcess
+
+
+struct enif_environment_t
+{
+    std::vector<ShimTerm *> m_Terms;
+    ShimProcess * m_Process;              //!< NULL unless a process env
+
+    enif_environment_t() : m_Process(NULL) {};
+};
+
+
+struct enif_resource_type_t
+{
+    std::string m_Name;
+    ErlNifResourceDtor * m_Dtor;
+};
+
+
+struct ShimResource
+{
+    ErlNifResourceType * m_Type;
+    volatile uint32_t m_Refs;
+    union
+    {
+        double m_Double;
+        uint64_t m_Int;
+        void * m_Ptr;
+    } m_Data[1];                          //!< user object starts here, aligned
+};
+
+
+struct ErlDrvMutex_ { pthread_mutex_t m_Mutex; };
+struct ErlDrvCond_ { pthread_cond_t m_Cond; };
+struct ErlDrvTid_ { pthread_t m_Thread; };
+
+
+static pthread_mutex_t gShimMutex=PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, ShimTerm *> gAtoms;
+static std::map<int64_t, ShimProcess *> gProcesses;
+static volatile uint64_t gNextId=0;
+static void * gPrivData=NULL;
+
+
+static ERL_NIF_TERM
+NilTerm()
+{
+    static ShimTerm * nil=NULL;
+
+    if (NULL==nil)
+    {
+        nil=new ShimTerm(ShimTerm::eNil);
+        nil->m_Immortal=true;
+    }   // if
+
+    return((ERL_NIF_TERM)nil);
+}   // NilTerm
+
+
+static ShimResource *
+ResourceHeader(
+    void * Obj)
+{
+    return((ShimResource *)((char *)Obj - offsetof(ShimResource, m_Data)));
+}   // ResourceHeader
+
+
+static void
+ReleaseResource(
+    ShimResource * Resource)
+{
+    if (0==__sync_sub_and_fetch(&Resource->m_Refs, 1))
+    {
+        if (NULL!=Resource->m_Type->m_Dtor)
+            (*Resource->m_Type->m_Dtor)(NULL, Resource->m_Data);
+        free(Resource);
+    }   // if
+}   // ReleaseResource
+
+
+static ShimTerm *
+Term(
+    ERL_NIF_TERM Value)
+{
+    return((ShimTerm *)Value);
+}   // Term
+
+
+static ERL_NIF_TERM
+NewTerm(
+    ErlNifEnv * Env,
+    ShimTerm * NewOne)
+{
+    Env->m_Terms.push_back(NewOne);
+    return((ERL_NIF_TERM)NewOne);
+}   // NewTerm
+
+
+static void
+PurgeEnv(
+    ErlNifEnv * Env)
+{
+    std::vector<ShimTerm *>::iterator it;
+
+    for (it=Env->m_Terms.begin(); Env->m_Terms.end()!=it; ++it)
+    {
+        if (NULL!=(*it)->m_Resource)
+            ReleaseResource((*it)->m_Resource);
+        free((*it)->m_Data);
+        delete *it;
+    }   // for
+
+    Env->m_Terms.clear();
+}   // PurgeEnv
+
+
+static ERL_NIF_TERM
+CopyTerm(
+    ErlNifEnv * Env,
+    ERL_NIF_TERM Source)
+{
+    ShimTerm * src, * dst;
+    size_t loop;
+
+    src=Term(Source);
+    if (src->m_Immortal)
+        return(Source);
+
+    dst=new ShimTerm(src->m_Kind);
+    dst->m_Int=src->m_Int;
+    dst->m_Double=src->m_Double;
+
+    if (ShimTerm::eBinary==src->m_Kind)
+    {
+        dst->m_Size=src->m_Size;
+        dst->m_Data=(unsigned char *)malloc(src->m_Size ? src->m_Size : 1);
+        memcpy(dst->m_Data, src->m_Data, src->m_Size);
+    }   // if
+
+    if (NULL!=src->m_Resource)
+    {
+        dst->m_Resource=src->m_Resource;
+        __sync_add_and_fetch(&dst->m_Resource->m_Refs, 1);
+    }   // if
+
+    for (loop=0; loop<src->m_Elems.size(); ++loop)
+        dst->m_Elems.push_back(CopyTerm(Env, src->m_Elems[loop]));
+
+    return(NewTerm(Env, dst));
+
+}   // CopyTerm
+
+
+static ERL_NIF_TERM
+MakeInt(
+    ErlNifEnv * Env,
+    int64_t Value)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eInt);
+
+    term->m_Int=Value;
+    return(NewTerm(Env, term));
+}   // MakeInt
+
+
+static ERL_NIF_TERM
+MakeList(
+    ErlNifEnv * Env,
+    const ERL_NIF_TERM * Array,
+    unsigned Count)
+{
+    ERL_NIF_TERM list;
+
+    list=NilTerm();
+    while (0<Count)
+    {
+        --Count;
+        list=enif_make_list_cell(Env, Array[Count], list);
+    }   // while
+
+    return(list);
+}   // MakeList
+
+
+/**
+ * erl_nif entry points
+ */
+
+extern "C" {
+
+void * enif_priv_data(ErlNifEnv *) {return(gPrivData);}
+
+void * enif_alloc(size_t size) {return(malloc(size));}
+
+void enif_free(void * ptr) {free(ptr);}
+
+int enif_is_atom(ErlNifEnv *, ERL_NIF_TERM term) {return(ShimTerm::eAtom==Term(term)->m_Kind);}
+
+int enif_is_binary(ErlNifEnv *, ERL_NIF_TERM term) {return(ShimTerm::eBinary==Term(term)->m_Kind);}
+
+int enif_is_ref(ErlNifEnv *, ERL_NIF_TERM term) {return(ShimTerm::eRef==Term(term)->m_Kind);}
+
+int enif_is_pid(ErlNifEnv *, ERL_NIF_TERM term) {return(ShimTerm::ePid==Term(term)->m_Kind);}
+
+int enif_is_list(ErlNifEnv *, ERL_NIF_TERM term)
+{
+    return(ShimTerm::eCons==Term(term)->m_Kind || ShimTerm::eNil==Term(term)->m_Kind);
+}
+
+
+int
+enif_inspect_binary(
+    ErlNifEnv *,
+    ERL_NIF_TERM bin_term,
+    ErlNifBinary * bin)
+{
+    ShimTerm * term=Term(bin_term);
+
+    if (ShimTerm::eBinary!=term->m_Kind)
+        return(0);
+
+    memset(bin, 0, sizeof(ErlNifBinary));
+    bin->size=term->m_Size;
+    bin->data=term->m_Data;
+    return(1);
+}   // enif_inspect_binary
+
+
+ERL_NIF_TERM enif_make_badarg(ErlNifEnv * env) {return(enif_make_atom(env, "badarg"));}
+
+
+int
+enif_get_int(
+    ErlNifEnv *,
+    ERL_NIF_TERM term,
+    int * ip)
+{
+    ShimTerm * ptr=Term(term);
+
+    if (ShimTerm::eInt!=ptr->m_Kind || ptr->m_Int!=(int)ptr->m_Int)
+        return(0);
+
+    *ip=(int)ptr->m_Int;
+    return(1);
+}   // enif_get_int
+
+
+int
+enif_get_uint(
+    ErlNifEnv *,
+    ERL_NIF_TERM term,
+    unsigned * ip)
+{
+    ShimTerm * ptr=Term(term);
+
+    if (ShimTerm::eInt!=ptr->m_Kind || ptr->m_Int<0 || ptr->m_Int!=(unsigned)ptr->m_Int)
+        return(0);
+
+    *ip=(unsigned)ptr->m_Int;
+    return(1);
+}   // enif_get_uint
+
+
+int
+enif_get_ulong(
+    ErlNifEnv *,
+    ERL_NIF_TERM term,
+    unsigned long * ip)
+{
+    ShimTerm * ptr=Term(term);
+
+    if (ShimTerm::eInt!=ptr->m_Kind || ptr->m_Int<0)
+        return(0);
+
+    *ip=(unsigned long)ptr->m_Int;
+    return(1);
+}   // enif_get_ulong
+
+
+int
+enif_get_list_cell(
+    ErlNifEnv *,
+    ERL_NIF_TERM term,
+    ERL_NIF_TERM * head,
+    ERL_NIF_TERM * tail)
+{
+    ShimTerm * ptr=Term(term);
+
+    if (ShimTerm::eCons!=ptr->m_Kind)
+        return(0);
+
+    *head=ptr->m_Elems[0];
+    *tail=ptr->m_Elems[1];
+    return(1);
+}   // enif_get_list_cell
+
+
+int
+enif_get_list_length(
+    ErlNifEnv * env,
+    ERL_NIF_TERM term,
+    unsigned * len)
+{
+    ERL_NIF_TERM head;
+
+    *len=0;
+    while (enif_get_list_cell(env, term, &head, &term))
+        ++(*len);
+
+    return(ShimTerm::eNil==Term(term)->m_Kind);
+}   // enif_get_list_length
+
+
+int
+enif_get_tuple(
+    ErlNifEnv *,
+    ERL_NIF_TERM tpl,
+    int * arity,
+    const ERL_NIF_TERM ** array)
+{
+    ShimTerm * ptr=Term(tpl);
+
+    if (ShimTerm::eTuple!=ptr->m_Kind)
+        return(0);
+
+    *arity=(int)ptr->m_Elems.size();
+    *array=ptr->m_Elems.empty() ? NULL : &ptr->m_Elems[0];
+    return(1);
+}   // enif_get_tuple
+
+
+int
+enif_get_string(
+    ErlNifEnv * env,
+    ERL_NIF_TERM list,
+    char * buf,
+    unsigned len,
+    ErlNifCharEncoding)
+{
+    ERL_NIF_TERM head;
+    unsigned used;
+
+    if (0==len || !enif_is_list(env, list))
+        return(0);
+
+    used=0;
+    while (enif_get_list_cell(env, list, &head, &list))
+    {
+        if (ShimTerm::eInt!=Term(head)->m_Kind)
+            return(0);
+
+        // Erlang's convention: negative count when truncated
+        if (used+1==len)
+        {
+            buf[used]='\0';
+            return(-(int)len);
+        }   // if
+
+        buf[used++]=(char)Term(head)->m_Int;
+    }   // while
+
+    buf[used]='\0';
+    return((int)used+1);
+}   // enif_get_string
+
+
+ERL_NIF_TERM enif_make_int(ErlNifEnv * env, int i) {return(MakeInt(env, i));}
+
+ERL_NIF_TERM enif_make_uint(ErlNifEnv * env, unsigned i) {return(MakeInt(env, i));}
+
+ERL_NIF_TERM enif_make_long(ErlNifEnv * env, long i) {return(MakeInt(env, i));}
+
+ERL_NIF_TERM enif_make_ulong(ErlNifEnv * env, unsigned long i) {return(MakeInt(env, (int64_t)i));}
+
+
+ERL_NIF_TERM
+enif_make_double(
+    ErlNifEnv * env,
+    double d)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eDouble);
+
+    term->m_Double=d;
+    return(NewTerm(env, term));
+}   // enif_make_double
+
+
+ERL_NIF_TERM
+enif_make_atom(
+    ErlNifEnv *,
+    const char * name)
+{
+    ShimTerm * ret_ptr;
+    std::map<std::string, ShimTerm *>::iterator it;
+
+    // interned so that == works as it does in the VM
+    pthread_mutex_lock(&gShimMutex);
+    it=gAtoms.find(name);
+    if (gAtoms.end()==it)
+    {
+        ret_ptr=new ShimTerm(ShimTerm::eAtom);
+        ret_ptr->m_Immortal=true;
+        ret_ptr->m_Name=name;
+        gAtoms[name]=ret_ptr;
+    }   // if
+    else
+    {
+        ret_ptr=it->second;
+    }   // else
+    pthread_mutex_unlock(&gShimMutex);
+
+    return((ERL_NIF_TERM)ret_ptr);
+
+}   // enif_make_atom
+
+
+ERL_NIF_TERM
+enif_make_tuple(
+    ErlNifEnv * env,
+    unsigned cnt,
+    ...)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eTuple);
+    va_list ap;
+
+    va_start(ap, cnt);
+    for (; 0<cnt; --cnt)
+        term->m_Elems.push_back(va_arg(ap, ERL_NIF_TERM));
+    va_end(ap);
+
+    return(NewTerm(env, term));
+}   // enif_make_tuple
+
+
+ERL_NIF_TERM
+enif_make_tuple_from_array(
+    ErlNifEnv * env,
+    const ERL_NIF_TERM arr[],
+    unsigned cnt)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eTuple);
+
+    term->m_Elems.assign(arr, arr+cnt);
+    return(NewTerm(env, term));
+}   // enif_make_tuple_from_array
+
+
+ERL_NIF_TERM
+enif_make_list(
+    ErlNifEnv * env,
+    unsigned cnt,
+    ...)
+{
+    std::vector<ERL_NIF_TERM> elems;
+    va_list ap;
+    unsigned loop;
+
+    va_start(ap, cnt);
+    for (loop=0; loop<cnt; ++loop)
+        elems.push_back(va_arg(ap, ERL_NIF_TERM));
+    va_end(ap);
+
+    return(MakeList(env, elems.empty() ? NULL : &elems[0], cnt));
+}   // enif_make_list
+
+
+ERL_NIF_TERM
+enif_make_list_from_array(
+    ErlNifEnv * env,
+    const ERL_NIF_TERM arr[],
+    unsigned cnt)
+{
+    return(MakeList(env, arr, cnt));
+}   // enif_make_list_from_array
+
+
+ERL_NIF_TERM
+enif_make_list_cell(
+    ErlNifEnv * env,
+    ERL_NIF_TERM car,
+    ERL_NIF_TERM cdr)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eCons);
+
+    term->m_Elems.push_back(car);
+    term->m_Elems.push_back(cdr);
+    return(NewTerm(env, term));
+}   // enif_make_list_cell
+
+
+ERL_NIF_TERM
+enif_make_string(
+    ErlNifEnv * env,
+    const char * string,
+    ErlNifCharEncoding)
+{
+    std::vector<ERL_NIF_TERM> chars;
+
+    for (; '\0'!=*string; ++string)
+        chars.push_back(MakeInt(env, (unsigned char)*string));
+
+    return(MakeList(env, chars.empty() ? NULL : &chars[0], (unsigned)chars.size()));
+}   // enif_make_string
+
+
+ERL_NIF_TERM
+enif_make_ref(
+    ErlNifEnv * env)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eRef);
+
+    term->m_Int=(int64_t)__sync_add_and_fetch(&gNextId, 1);
+    return(NewTerm(env, term));
+}   // enif_make_ref
+
+
+unsigned char *
+enif_make_new_binary(
+    ErlNifEnv * env,
+    size_t size,
+    ERL_NIF_TERM * termp)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eBinary);
+
+    term->m_Size=size;
+    term->m_Data=(unsigned char *)malloc(size ? size : 1);
+    *termp=NewTerm(env, term);
+
+    return(term->m_Data);
+}   // enif_make_new_binary
+
+
+ErlNifPid *
+enif_self(
+    ErlNifEnv * caller_env,
+    ErlNifPid * pid)
+{
+    if (NULL==caller_env || NULL==caller_env->m_Process)
+        return(NULL);
+
+    pid->pid=caller_env->m_Process->m_Pid;
+    return(pid);
+}   // enif_self
+
+
+int
+enif_get_local_pid(
+    ErlNifEnv *,
+    ERL_NIF_TERM term,
+    ErlNifPid * pid)
+{
+    if (ShimTerm::ePid!=Term(term)->m_Kind)
+        return(0);
+
+    pid->pid=term;
+    return(1);
+}   // enif_get_local_pid
+
+
+ErlNifEnv * enif_alloc_env(void) {return(new enif_environment_t);}
+
+void enif_clear_env(ErlNifEnv * env) {PurgeEnv(env);}
+
+void
+enif_free_env(
+    ErlNifEnv * env)
+{
+    PurgeEnv(env);
+    delete env;
+}   // enif_free_env
+
+
+int
+enif_send(
+    ErlNifEnv *,
+    const ErlNifPid * to_pid,
+    ErlNifEnv * msg_env,
+    ERL_NIF_TERM msg)
+{
+    ShimProcess * process;
+    std::map<int64_t, ShimProcess *>::iterator it;
+    ErlNifEnv * copy_env;
+
+    pthread_mutex_lock(&gShimMutex);
+    it=gProcesses.find(Term(to_pid->pid)->m_Int);
+    process=(gProcesses.end()!=it) ? it->second : NULL;
+    pthread_mutex_unlock(&gShimMutex);
+
+    if (NULL==process)
+        return(0);
+
+    // VM semantics: message is copied, msg_env is cleared
+    copy_env=enif_alloc_env();
+    msg=CopyTerm(copy_env, msg);
+    if (NULL!=msg_env)
+        enif_clear_env(msg_env);
+
+    pthread_mutex_lock(&process->m_Mutex);
+    process->m_Mailbox.push_back(std::make_pair(copy_env, msg));
+    pthread_cond_broadcast(&process->m_Cond);
+    pthread_mutex_unlock(&process->m_Mutex);
+
+    return(1);
+
+}   // enif_send
+
+
+ERL_NIF_TERM enif_make_copy(ErlNifEnv * dst_env, ERL_NIF_TERM src_term) {return(CopyTerm(dst_env, src_term));}
+
+
+ErlNifResourceType *
+enif_open_resource_type(
+    ErlNifEnv *,
+    const char *,
+    const char * name_str,
+    ErlNifResourceDtor * dtor,
+    ErlNifResourceFlags,
+    ErlNifResourceFlags * tried)
+{
+    ErlNifResourceType * type=new ErlNifResourceType;
+
+    type->m_Name=name_str;
+    type->m_Dtor=dtor;
+    if (NULL!=tried)
+        *tried=ERL_NIF_RT_CREATE;
+
+    return(type);
+}   // enif_open_resource_type
+
+
+void *
+enif_alloc_resource(
+    ErlNifResourceType * type,
+    size_t size)
+{
+    ShimResource * resource;
+
+    resource=(ShimResource *)malloc(offsetof(ShimResource, m_Data) + size);
+    resource->m_Type=type;
+    resource->m_Refs=1;
+
+    return(resource->m_Data);
+}   // enif_alloc_resource
+
+
+void enif_release_resource(void * obj) {ReleaseResource(ResourceHeader(obj));}
+
+
+ERL_NIF_TERM
+enif_make_resource(
+    ErlNifEnv * env,
+    void * obj)
+{
+    ShimTerm * term=new ShimTerm(ShimTerm::eResource);
+
+    // the term holds a reference until its env is cleared
+    term->m_Resource=ResourceHeader(obj);
+    __sync_add_and_fetch(&term->m_Resource->m_Refs, 1);
+
+    return(NewTerm(env, term));
+}   // enif_make_resource
+
+
+int
+enif_get_resource(
+    ErlNifEnv *,
+    ERL_NIF_TERM term,
+    ErlNifResourceType * type,
+    void ** objp)
+{
+    ShimTerm * ptr=Term(term);
+
+    if (ShimTerm::eResource!=ptr->m_Kind || type!=ptr->m_Resource->m_Type)
+        return(0);
+
+    *objp=ptr->m_Resource->m_Data;
+    return(1);
+}   // enif_get_resource
+
+
+ErlNifMutex *
+enif_mutex_create(
+    char *)
+{
+    ErlNifMutex * mtx=new ErlNifMutex;
+
+    pthread_mutex_init(&mtx->m_Mutex, NULL);
+    return(mtx);
+}   // enif_mutex_create
+
+
+void
+enif_mutex_destroy(
+    ErlNifMutex * mtx)
+{
+    pthread_mutex_destroy(&mtx->m_Mutex);
+    delete mtx;
+}   // enif_mutex_destroy
+
+
+void enif_mutex_lock(ErlNifMutex * mtx) {pthread_mutex_lock(&mtx->m_Mutex);}
+
+void enif_mutex_unlock(ErlNifMutex * mtx) {pthread_mutex_unlock(&mtx->m_Mutex);}
+
+
+ErlNifCond *
+enif_cond_create(
+    char *)
+{
+    ErlNifCond * cnd=new ErlNifCond;
+
+    pthread_cond_init(&cnd->m_Cond, NULL);
+    return(cnd);
+}   // enif_cond_create
+
+
+void
+enif_cond_destroy(
+    ErlNifCond * cnd)
+{
+    pthread_cond_destroy(&cnd->m_Cond);
+    delete cnd;
+}   // enif_cond_destroy
+
+
+void enif_cond_signal(ErlNifCond * cnd) {pthread_cond_signal(&cnd->m_Cond);}
+
+void enif_cond_broadcast(ErlNifCond * cnd) {pthread_cond_broadcast(&cnd->m_Cond);}
+
+void enif_cond_wait(ErlNifCond * cnd, ErlNifMutex * mtx) {pthread_cond_wait(&cnd->m_Cond, &mtx->m_Mutex);}
+
+
+int
+enif_thread_create(
+    char *,
+    ErlNifTid * tid,
+    void * (*func)(void *),
+    void * args,
+    ErlNifThreadOpts *)
+{
+    int ret_val;
+
+    *tid=new ErlDrvTid_;
+    ret_val=pthread_create(&(*tid)->m_Thread, NULL, func, args);
+    if (0!=ret_val)
+    {
+        delete *tid;
+        *tid=NULL;
+    }   // if
+
+    return(ret_val);
+}   // enif_thread_create
+
+
+int
+enif_thread_join(
+    ErlNifTid tid,
+    void ** respp)
+{
+    int ret_val;
+
+    ret_val=pthread_join(tid->m_Thread, respp);
+    delete tid;
+
+    return(ret_val);
+}   // enif_thread_join
+
+}   // extern "C"
+
+
+/**
+ * helpers for the benchmark driver
+ */
+
+namespace shim {
+
+ErlNifEnv *
+NewProcessEnv()
+{
+    ErlNifEnv * env;
+    ShimProcess * process;
+    ShimTerm * pid;
+
+    pid=new ShimTerm(ShimTerm::ePid);
+    pid->m_Immortal=true;
+    pid->m_Int=(int64_t)__sync_add_and_fetch(&gNextId, 1);
+
+    process=new ShimProcess;
+    process->m_Pid=(ERL_NIF_TERM)pid;
+
+    env=enif_alloc_env();
+    env->m_Process=process;
+
+    pthread_mutex_lock(&gShimMutex);
+    gProcesses[pid->m_Int]=process;
+    pthread_mutex_unlock(&gShimMutex);
+
+    return(env);
+
+}   // NewProcessEnv
+
+
+int
+LoadNif(
+    ErlNifEntry * Entry,
+    ErlNifEnv * Env,
+    ERL_NIF_TERM LoadInfo)
+{
+    return((*Entry->load)(Env, &gPrivData, LoadInfo));
+}   // LoadNif
+
+
+void
+UnloadNif(
+    ErlNifEntry * Entry,
+    ErlNifEnv * Env)
+{
+    if (NULL!=Entry->unload)
+        (*Entry->unload)(Env, gPrivData);
+    gPrivData=NULL;
+}   // UnloadNif
+
+
+const ErlNifFunc *
+FindNif(
+    ErlNifEntry * Entry,
+    const char * Name,
+    unsigned Arity)
+{
+    int loop;
+
+    for (loop=0; loop<Entry->num_of_funcs; ++loop)
+    {
+        if (0==strcmp(Name, Entry->funcs[loop].name) && Arity==Entry->funcs[loop].arity)
+            return(&Entry->funcs[loop]);
+    }   // for
+
+    return(NULL);
+}   // FindNif
+
+
+bool
+TermEqual(
+    ERL_NIF_TERM Lhs,
+    ERL_NIF_TERM Rhs)
+{
+    ShimTerm * lhs=Term(Lhs), * rhs=Term(Rhs);
+    size_t loop;
+    bool ret_flag;
+
+    if (Lhs==Rhs)
+        return(true);
+
+    ret_flag=(lhs->m_Kind==rhs->m_Kind && lhs->m_Int==rhs->m_Int
+              && lhs->m_Double==rhs->m_Double
+              && lhs->m_Resource==rhs->m_Resource
+              && lhs->m_Size==rhs->m_Size
+              && lhs->m_Elems.size()==rhs->m_Elems.size()
+              && ShimTerm::eAtom!=lhs->m_Kind);   // atoms are interned
+
+    if (ret_flag && 0!=lhs->m_Size)
+        ret_flag=(0==memcmp(lhs->m_Data, rhs->m_Data, lhs->m_Size));
+
+    for (loop=0; ret_flag && loop<lhs->m_Elems.size(); ++loop)
+        ret_flag=TermEqual(lhs->m_Elems[loop], rhs->m_Elems[loop]);
+
+    return(ret_flag);
+
+}   // TermEqual
+
+
+bool
+IsRef(
+    ERL_NIF_TERM Value)
+{
+    return(ShimTerm::eRef==Term(Value)->m_Kind);
+}   // IsRef
+
+
+ERL_NIF_TERM
+Receive(
+    ErlNifEnv * ProcessEnv,
+    ERL_NIF_TERM Ref,
+    ErlNifEnv ** MsgEnv)
+{
+    ShimProcess * process=ProcessEnv->m_Process;
+    ERL_NIF_TERM ret_term;
+    bool found;
+
+    ret_term=0;
+    found=false;
+
+    pthread_mutex_lock(&process->m_Mutex);
+    while (!found)
+    {
+        std::deque<std::pair<ErlNifEnv *, ERL_NIF_TERM> >::iterator it;
+
+        for (it=process->m_Mailbox.begin(); !found && process->m_Mailbox.end()!=it; ++it)
+        {
+            ShimTerm * msg=Term(it->second);
+
+            if (ShimTerm::eTuple==msg->m_Kind && 2==msg->m_Elems.size()
+                && TermEqual(msg->m_Elems[0], Ref))
+            {
+                found=true;
+                *MsgEnv=it->first;
+                ret_term=msg->m_Elems[1];
+                process->m_Mailbox.erase(it);
+                break;
+            }   // if
+        }   // for
+
+        if (!found)
+            pthread_cond_wait(&process->m_Cond, &process->m_Mutex);
+    }   // while
+    pthread_mutex_unlock(&process->m_Mutex);
+
+    return(ret_term);
+
+}   // Receive
+
+}   // namespace shim
@@ -0,0 +1,65 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#ifndef INCL_ERL_NIF_SHIM_H
+#define INCL_ERL_NIF_SHIM_H
+
+/**
+ * Minimal stand in for the Erlang VM side of the NIF API.  Lets the
+ *  eleveldb sources run inside a plain C++ program:  terms live in
+ *  ErlNifEnv arenas, resources are reference counted and released
+ *  when the last env holding them is cleared (a crude GC), and each
+ *  "process" env owns a mailbox that enif_send() delivers to.
+ *
+ *  Only the subset of erl_nif used by eleveldb is implemented.
+ */
+
+#include "erl_nif.h"
+
+extern "C" ErlNifEntry* nif_init(void);
+
+namespace shim {
+
+// env with its own pid and mailbox, stands in for an Erlang process
+ErlNifEnv * NewProcessEnv();
+
+// run the module's load callback once, priv data then visible to all envs
+int LoadNif(ErlNifEntry * Entry, ErlNifEnv * Env, ERL_NIF_TERM LoadInfo);
+
+void UnloadNif(ErlNifEntry * Entry, ErlNifEnv * Env);
+
+const ErlNifFunc * FindNif(ErlNifEntry * Entry, const char * Name, unsigned Arity);
+
+// structural equality, enough for matching refs and atoms
+bool TermEqual(ERL_NIF_TERM Lhs, ERL_NIF_TERM Rhs);
+
+bool IsRef(ERL_NIF_TERM Term);
+
+/**
+ * Selective receive of {Ref, Reply} on the process owning ProcessEnv.
+ *  Blocks until it arrives.  Reply lives in *MsgEnv, caller frees it.
+ */
+ERL_NIF_TERM Receive(ErlNifEnv * ProcessEnv, ERL_NIF_TERM Ref, ErlNifEnv ** MsgEnv);
+
+}   // namespace shim
+
+#endif  // INCL_ERL_NIF_SHIM_H
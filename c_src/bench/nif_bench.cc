@@ -0,0 +1,583 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+/**
+ * Standalone benchmark of the NIF layer:  thread pool handoff,
+ *  WorkTask submit-to-completion latency and iterator prefetch.
+ *  Runs the real eleveldb and leveldb code against erl_nif_shim.
+ *
+ *  Usage: eleveldb_bench [-o file.json] [-n ops] [-k keys]
+ *                        [-c clients] [-t threads,threads,...] [-d dir]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/perf_count.h"
+
+#ifndef INCL_ERL_NIF_SHIM_H
+    #include "erl_nif_shim.h"
+#endif
+
+#ifndef INCL_DBSTATS_H
+    #include "dbstats.h"
+#endif
+
+#ifndef INCL_THREADING_H
+    #include "threading.h"
+#endif
+
+#ifndef INCL_WORKITEMS_H
+    #include "workitems.h"
+#endif
+
+
+/**
+ * Smallest possible work item:  measures pool overhead only
+ */
+class NoopTask : public eleveldb::WorkTask
+{
+public:
+    NoopTask(ErlNifEnv * CallerEnv, ERL_NIF_TERM & CallerRef)
+        : eleveldb::WorkTask(CallerEnv, CallerRef)
+    {};
+
+    virtual ~NoopTask() {};
+
+    virtual eleveldb::work_result operator()() {return(eleveldb::work_result(eleveldb::ATOM_OK));};
+};  // class NoopTask
+
+
+/**
+ * One named set of numbers, becomes one JSON object
+ */
+struct BenchResult
+{
+    std::string m_Name;
+    std::vector<std::pair<std::string, double> > m_Values;
+
+    explicit BenchResult(const char * Name) : m_Name(Name) {};
+
+    void Add(const char * Key, double Value) {m_Values.push_back(std::make_pair(std::string(Key), Value));};
+};  // struct BenchResult
+
+
+struct BenchConfig
+{
+    size_t m_Ops;
+    size_t m_Keys;
+    size_t m_Clients;
+    std::vector<size_t> m_Threads;
+    std::string m_Dir;
+    std::string m_Output;
+
+    BenchConfig()
+        : m_Ops(100000), m_Keys(100000), m_Clients(8), m_Dir("/tmp/eleveldb.bench")
+    {};
+};  // struct BenchConfig
+
+
+static double
+Percentile(
+    std::vector<uint64_t> & Sorted,
+    double Pct)
+{
+    size_t index;
+
+    if (Sorted.empty())
+        return(0.0);
+
+    index=(size_t)(Pct * (Sorted.size()-1) / 100.0 + 0.5);
+    return((double)Sorted[index]);
+}   // Percentile
+
+
+/**
+ * Submit one NoopTask at a time, wait for its message
+ */
+static void
+SubmitLatency(
+    const BenchConfig & Config,
+    size_t Threads,
+    std::vector<BenchResult> & Results)
+{
+    // pools are never deleted: drain_thread_pool() does not join workers
+    eleveldb::eleveldb_thread_pool * pool=new eleveldb::eleveldb_thread_pool(Threads);
+    ErlNifEnv * process=shim::NewProcessEnv();
+    ErlNifEnv * scratch=enif_alloc_env();
+    std::vector<uint64_t> samples;
+    uint64_t total;
+    size_t loop;
+
+    samples.reserve(Config.m_Ops);
+    total=0;
+
+    for (loop=0; loop<Config.m_Ops; ++loop)
+    {
+        ERL_NIF_TERM ref;
+        ErlNifEnv * msg_env;
+        uint64_t start;
+
+        ref=enif_make_ref(scratch);
+        start=eleveldb::MonotonicMicros();
+        pool->submit(new NoopTask(process, ref));
+        shim::Receive(process, ref, &msg_env);
+        samples.push_back(eleveldb::MonotonicMicros() - start);
+        total+=samples.back();
+
+        enif_free_env(msg_env);
+        enif_clear_env(scratch);
+    }   // for
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result("submit_latency");
+    result.Add("threads", (double)Threads);
+    result.Add("ops", (double)Config.m_Ops);
+    result.Add("mean_us", (double)total / Config.m_Ops);
+    result.Add("p50_us", Percentile(samples, 50.0));
+    result.Add("p90_us", Percentile(samples, 90.0));
+    result.Add("p99_us", Percentile(samples, 99.0));
+    result.Add("p999_us", Percentile(samples, 99.9));
+    result.Add("max_us", (double)samples.back());
+    Results.push_back(result);
+
+    enif_free_env(scratch);
+
+}   // SubmitLatency
+
+
+struct ClientArgs
+{
+    eleveldb::eleveldb_thread_pool * m_Pool;
+    size_t m_Ops;
+};
+
+
+// one "Erlang process":  synchronous calls, like eleveldb:get/3
+static void *
+ThroughputClient(
+    void * Args)
+{
+    ClientArgs * args=(ClientArgs *)Args;
+    ErlNifEnv * process=shim::NewProcessEnv();
+    ErlNifEnv * scratch=enif_alloc_env();
+    size_t loop;
+
+    for (loop=0; loop<args->m_Ops; ++loop)
+    {
+        ERL_NIF_TERM ref;
+        ErlNifEnv * msg_env;
+
+        ref=enif_make_ref(scratch);
+        args->m_Pool->submit(new NoopTask(process, ref));
+        shim::Receive(process, ref, &msg_env);
+
+        enif_free_env(msg_env);
+        enif_clear_env(scratch);
+    }   // for
+
+    enif_free_env(scratch);
+    return(NULL);
+
+}   // ThroughputClient
+
+
+/**
+ * Many clients against one pool, reports ops/sec and how work
+ *  reached the workers (direct handoff or backlog queue)
+ */
+static void
+Throughput(
+    const BenchConfig & Config,
+    size_t Threads,
+    std::vector<BenchResult> & Results)
+{
+    eleveldb::eleveldb_thread_pool * pool=new eleveldb::eleveldb_thread_pool(Threads);
+    std::vector<pthread_t> clients(Config.m_Clients);
+    ClientArgs args;
+    uint64_t start, elapsed, direct, queued, dequeued;
+    size_t loop;
+
+    args.m_Pool=pool;
+    args.m_Ops=Config.m_Ops / Config.m_Clients;
+
+    direct=leveldb::gPerfCounters->Value(leveldb::ePerfElevelDirect);
+    queued=leveldb::gPerfCounters->Value(leveldb::ePerfElevelQueued);
+    dequeued=leveldb::gPerfCounters->Value(leveldb::ePerfElevelDequeued);
+    start=eleveldb::MonotonicMicros();
+
+    for (loop=0; loop<clients.size(); ++loop)
+        pthread_create(&clients[loop], NULL, ThroughputClient, &args);
+    for (loop=0; loop<clients.size(); ++loop)
+        pthread_join(clients[loop], NULL);
+
+    elapsed=eleveldb::MonotonicMicros() - start;
+
+    BenchResult result("throughput");
+    result.Add("threads", (double)Threads);
+    result.Add("clients", (double)Config.m_Clients);
+    result.Add("ops", (double)(args.m_Ops * Config.m_Clients));
+    result.Add("seconds", elapsed / 1000000.0);
+    result.Add("ops_per_sec", (args.m_Ops * Config.m_Clients) * 1000000.0 / (elapsed ? elapsed : 1));
+    result.Add("direct", (double)(leveldb::gPerfCounters->Value(leveldb::ePerfElevelDirect) - direct));
+    result.Add("queued", (double)(leveldb::gPerfCounters->Value(leveldb::ePerfElevelQueued) - queued));
+    result.Add("dequeued", (double)(leveldb::gPerfCounters->Value(leveldb::ePerfElevelDequeued) - dequeued));
+    Results.push_back(result);
+
+}   // Throughput
+
+
+/**
+ * Call a NIF by name and, if it answers through a message, wait for it.
+ *  Reply is copied into Holder.
+ */
+static ERL_NIF_TERM
+CallNif(
+    ErlNifEntry * Entry,
+    ErlNifEnv * Process,
+    ErlNifEnv * Holder,
+    const char * Name,
+    unsigned Argc,
+    const ERL_NIF_TERM * Argv)
+{
+    const ErlNifFunc * func;
+    ERL_NIF_TERM ret_term;
+    ErlNifEnv * msg_env;
+
+    func=shim::FindNif(Entry, Name, Argc);
+    if (NULL==func)
+    {
+        fprintf(stderr, "eleveldb_bench: no NIF %s/%u\n", Name, Argc);
+        exit(1);
+    }   // if
+
+    ret_term=(*func->fptr)(Process, (int)Argc, Argv);
+
+    // async NIFs answer 'ok' then send {CallerRef, Reply}
+    if (0!=Argc && shim::IsRef(Argv[0]) && ret_term==eleveldb::ATOM_OK)
+    {
+        ret_term=shim::Receive(Process, Argv[0], &msg_env);
+        ret_term=enif_make_copy(Holder, ret_term);
+        enif_free_env(msg_env);
+    }   // if
+    else
+    {
+        ret_term=enif_make_copy(Holder, ret_term);
+    }   // else
+
+    return(ret_term);
+
+}   // CallNif
+
+
+static ERL_NIF_TERM
+Element(
+    ErlNifEnv * Env,
+    ERL_NIF_TERM Tuple,
+    int Index)
+{
+    const ERL_NIF_TERM * array;
+    int arity;
+
+    if (!enif_get_tuple(Env, Tuple, &arity, &array) || arity<=Index)
+    {
+        fprintf(stderr, "eleveldb_bench: unexpected reply from NIF\n");
+        exit(1);
+    }   // if
+
+    return(array[Index]);
+}   // Element
+
+
+/**
+ * Full iteration of a database through async_iterator_move,
+ *  once with plain 'next' and once with 'prefetch'
+ */
+static void
+MovePrefetch(
+    ErlNifEntry * Entry,
+    const BenchConfig & Config,
+    std::vector<BenchResult> & Results)
+{
+    ErlNifEnv * process=shim::NewProcessEnv();
+    ErlNifEnv * holder=enif_alloc_env();
+    ERL_NIF_TERM argv[4], reply, db, name, open_opts, empty;
+    size_t loop, batch_size;
+    const char * modes[2]={"next", "prefetch"};
+    int mode;
+
+    name=enif_make_string(holder, Config.m_Dir.c_str(), ERL_NIF_LATIN1);
+    empty=enif_make_list(holder, 0);
+    open_opts=enif_make_list1(holder,
+                              enif_make_tuple2(holder, enif_make_atom(holder, "create_if_missing"),
+                                               enif_make_atom(holder, "true")));
+
+    argv[0]=enif_make_ref(holder); argv[1]=name; argv[2]=empty;
+    CallNif(Entry, process, holder, "async_destroy", 3, argv);
+
+    argv[0]=enif_make_ref(holder); argv[1]=name; argv[2]=open_opts;
+    reply=CallNif(Entry, process, holder, "async_open", 3, argv);
+    db=Element(holder, reply, 1);
+
+    // load keys in batches of 1000, typical Riak sized values
+    batch_size=1000;
+    for (loop=0; loop<Config.m_Keys; loop+=batch_size)
+    {
+        ErlNifEnv * batch_env=enif_alloc_env();
+        std::vector<ERL_NIF_TERM> puts;
+        size_t key;
+
+        for (key=loop; key<loop+batch_size && key<Config.m_Keys; ++key)
+        {
+            ERL_NIF_TERM key_bin, value_bin;
+            unsigned char * ptr;
+            char key_buf[17];
+
+            // binary has no room for snprintf's terminating NUL
+            snprintf(key_buf, sizeof(key_buf), "%016zu", key);
+            ptr=enif_make_new_binary(batch_env, 16, &key_bin);
+            memcpy(ptr, key_buf, 16);
+            ptr=enif_make_new_binary(batch_env, 300, &value_bin);
+            memset(ptr, (int)(key & 0xff), 300);
+            puts.push_back(enif_make_tuple3(batch_env, enif_make_atom(batch_env, "put"),
+                                            key_bin, value_bin));
+        }   // for
+
+        argv[0]=enif_make_ref(batch_env); argv[1]=db;
+        argv[2]=enif_make_list_from_array(batch_env, &puts[0], (unsigned)puts.size());
+        argv[3]=enif_make_list(batch_env, 0);
+        CallNif(Entry, process, batch_env, "async_write", 4, argv);
+        enif_free_env(batch_env);
+    }   // for
+
+    for (mode=0; mode<2; ++mode)
+    {
+        ERL_NIF_TERM itr, action, undefined;
+        uint64_t start, elapsed, count;
+
+        argv[0]=enif_make_ref(holder); argv[1]=db; argv[2]=empty;
+        reply=CallNif(Entry, process, holder, "async_iterator", 3, argv);
+        itr=Element(holder, reply, 1);
+
+        undefined=enif_make_atom(holder, "undefined");
+        action=enif_make_atom(holder, "first");
+        count=0;
+        start=eleveldb::MonotonicMicros();
+
+        // mirrors eleveldb:iterator_move/2 and fold_loop/4
+        do
+        {
+            const ErlNifFunc * func;
+            ERL_NIF_TERM move_argv[3];
+            ErlNifEnv * msg_env;
+
+            move_argv[0]=undefined; move_argv[1]=itr; move_argv[2]=action;
+            func=shim::FindNif(Entry, "async_iterator_move", 3);
+            reply=(*func->fptr)(process, 3, move_argv);
+
+            msg_env=NULL;
+            if (shim::IsRef(reply))
+                reply=shim::Receive(process, reply, &msg_env);
+
+            if (eleveldb::ATOM_OK==Element(process, reply, 0))
+                ++count;
+            else
+                action=0;
+
+            if (NULL!=msg_env)
+                enif_free_env(msg_env);
+            enif_clear_env(process);
+
+            if (0!=action)
+                action=enif_make_atom(holder, modes[mode]);
+        } while(0!=action);
+
+        elapsed=eleveldb::MonotonicMicros() - start;
+
+        argv[0]=enif_make_ref(holder); argv[1]=itr;
+        CallNif(Entry, process, holder, "async_iterator_close", 2, argv);
+
+        BenchResult result("move_prefetch");
+        result.Add("prefetch", (double)mode);
+        result.Add("keys", (double)count);
+        result.Add("seconds", elapsed / 1000000.0);
+        result.Add("keys_per_sec", count * 1000000.0 / (elapsed ? elapsed : 1));
+        Results.push_back(result);
+    }   // for
+
+    argv[0]=enif_make_ref(holder); argv[1]=db;
+    CallNif(Entry, process, holder, "async_close", 2, argv);
+
+    argv[0]=enif_make_ref(holder); argv[1]=name; argv[2]=empty;
+    CallNif(Entry, process, holder, "async_destroy", 3, argv);
+
+    enif_free_env(holder);
+
+}   // MovePrefetch
+
+
+static void
+WriteJson(
+    FILE * Out,
+    const BenchConfig & Config,
+    const std::vector<BenchResult> & Results)
+{
+    size_t loop, value;
+
+    fprintf(Out, "{\n  \"benchmark\": \"eleveldb_nif\",\n");
+    fprintf(Out, "  \"timestamp\": %llu,\n", (unsigned long long)(eleveldb::NowMicros()/1000000));
+    fprintf(Out, "  \"clients\": %zu,\n", Config.m_Clients);
+    fprintf(Out, "  \"results\": [\n");
+
+    for (loop=0; loop<Results.size(); ++loop)
+    {
+        fprintf(Out, "    {\"name\": \"%s\"", Results[loop].m_Name.c_str());
+        for (value=0; value<Results[loop].m_Values.size(); ++value)
+            fprintf(Out, ", \"%s\": %.3f", Results[loop].m_Values[value].first.c_str(),
+                    Results[loop].m_Values[value].second);
+        fprintf(Out, "}%s\n", (loop+1<Results.size()) ? "," : "");
+    }   // for
+
+    fprintf(Out, "  ]\n}\n");
+
+}   // WriteJson
+
+
+static bool
+ParseArgs(
+    int argc,
+    char ** argv,
+    BenchConfig & Config)
+{
+    int opt;
+
+    while (-1!=(opt=getopt(argc, argv, "o:n:k:c:t:d:")))
+    {
+        switch(opt)
+        {
+            case 'o': Config.m_Output=optarg; break;
+            case 'n': Config.m_Ops=strtoul(optarg, NULL, 10); break;
+            case 'k': Config.m_Keys=strtoul(optarg, NULL, 10); break;
+            case 'c': Config.m_Clients=strtoul(optarg, NULL, 10); break;
+            case 'd': Config.m_Dir=optarg; break;
+            case 't':
+            {
+                char * cursor=optarg;
+
+                Config.m_Threads.clear();
+                while ('\0'!=*cursor)
+                {
+                    char * end;
+
+                    // digits required, then ',' or end of string
+                    Config.m_Threads.push_back(strtoul(cursor, &end, 10));
+                    if (end==cursor || ('\0'!=*end && ','!=*end))
+                        return(false);
+
+                    cursor=(','==*end) ? end+1 : end;
+                }   // while
+                break;
+            }   // case
+
+            default:
+                return(false);
+        }   // switch
+    }   // while
+
+    // stray arguments, e.g. "-t 4 8"
+    if (optind<argc)
+        return(false);
+
+    if (Config.m_Threads.empty())
+    {
+        const size_t defaults[]={1, 2, 4, 8, 16, 32, 71};
+
+        Config.m_Threads.assign(defaults, defaults + sizeof(defaults)/sizeof(defaults[0]));
+    }   // if
+
+    return(0!=Config.m_Ops && 0!=Config.m_Clients
+           && 0==std::count(Config.m_Threads.begin(), Config.m_Threads.end(), (size_t)0));
+
+}   // ParseArgs
+
+
+int
+main(
+    int argc,
+    char ** argv)
+{
+    BenchConfig config;
+    std::vector<BenchResult> results;
+    ErlNifEntry * entry;
+    ErlNifEnv * load_env;
+    FILE * out;
+    size_t loop;
+
+    if (!ParseArgs(argc, argv, config))
+    {
+        fprintf(stderr, "usage: %s [-o file.json] [-n ops] [-k keys] [-c clients]"
+                " [-t threads,threads,...] [-d dir]\n", argv[0]);
+        return(1);
+    }   // if
+
+    // same entry point the VM uses: sets up atoms, leveldb and priv data
+    entry=nif_init();
+    load_env=shim::NewProcessEnv();
+    if (0!=shim::LoadNif(entry, load_env, enif_make_list(load_env, 0)))
+    {
+        fprintf(stderr, "eleveldb_bench: NIF load failed\n");
+        return(1);
+    }   // if
+
+    for (loop=0; loop<config.m_Threads.size(); ++loop)
+        SubmitLatency(config, config.m_Threads[loop], results);
+
+    for (loop=0; loop<config.m_Threads.size(); ++loop)
+        Throughput(config, config.m_Threads[loop], results);
+
+    if (0!=config.m_Keys)
+        MovePrefetch(entry, config, results);
+
+    out=config.m_Output.empty() ? stdout : fopen(config.m_Output.c_str(), "w");
+    if (NULL==out)
+    {
+        perror(config.m_Output.c_str());
+        return(1);
+    }   // if
+
+    WriteJson(out, config, results);
+    if (stdout!=out)
+        fclose(out);
+
+    // no UnloadNif(): leveldb::Env::Shutdown() would race the idle pools
+    return(0);
+
+}   // main
@@ -0,0 +1,303 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#include <string.h>
+
+// x86 builds carry an AVX2 probe chosen at run time, the default
+//  -O3 flags do not enable AVX2 for the whole file.  gcc before 4.9
+//  rejects AVX2 intrinsics in target("avx2") functions and lacks
+//  __builtin_cpu_supports before 4.8, those keep the scalar probe
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || 4<__GNUC__ || (4==__GNUC__ && 9<=__GNUC_MINOR__))
+    #define ELEVELDB_BLOOM_AVX2 1
+    #include <immintrin.h>
+#endif
+
+#ifndef INCL_BLOOM_BLOCKED_H
+    #include "bloom_blocked.h"
+#endif
+
+
+namespace eleveldb {
+
+// odd constants from the Impala / Parquet split block bloom filter,
+//  one per 32 bit word of a block
+static const uint32_t gBloomSalt[BlockedBloomFilterPolicy::kBlockWords] =
+{
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+
+// words are stored little endian so filters move between platforms
+static inline uint32_t
+DecodeWord(
+    const char * Ptr)
+{
+    const unsigned char * p=(const unsigned char *)Ptr;
+
+    return((uint32_t)p[0] | ((uint32_t)p[1] << 8)
+           | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}   // DecodeWord
+
+
+static inline void
+EncodeWord(
+    char * Ptr,
+    uint32_t Value)
+{
+    unsigned char * p=(unsigned char *)Ptr;
+
+    p[0]=(unsigned char)Value;
+    p[1]=(unsigned char)(Value >> 8);
+    p[2]=(unsigned char)(Value >> 16);
+    p[3]=(unsigned char)(Value >> 24);
+}   // EncodeWord
+
+
+// upper 32 bits pick the block (multiply-shift avoids a modulo),
+//  lower 32 bits pick the bit within each word
+static inline size_t
+BlockIndex(
+    uint64_t Hash,
+    size_t NumBlocks)
+{
+    return((size_t)(((Hash >> 32) * (uint64_t)NumBlocks) >> 32));
+}   // BlockIndex
+
+
+// portable probe, no early exit so the compiler can vectorize the loop
+static bool
+ProbeBlock(
+    const char * Block,
+    uint32_t Key32)
+{
+    size_t word;
+    uint32_t missing;
+
+    missing=0;
+    for (word=0; word<BlockedBloomFilterPolicy::kBlockWords; ++word)
+    {
+        uint32_t mask;
+
+        mask=(uint32_t)1 << ((Key32 * gBloomSalt[word]) >> 27);
+        missing|=mask & ~DecodeWord(Block + word*4);
+    }   // for
+
+    return(0==missing);
+
+}   // ProbeBlock
+
+
+#if defined(ELEVELDB_BLOOM_AVX2)
+// all eight salted multiplies, shifts and bit tests in one pass.
+//  Only called when gHasAvx2, the words are little endian as on disk
+__attribute__((target("avx2")))
+static bool
+ProbeBlockAvx2(
+    const char * Block,
+    uint32_t Key32)
+{
+    const __m256i salts=_mm256_setr_epi32(
+        (int)gBloomSalt[0], (int)gBloomSalt[1], (int)gBloomSalt[2], (int)gBloomSalt[3],
+        (int)gBloomSalt[4], (int)gBloomSalt[5], (int)gBloomSalt[6], (int)gBloomSalt[7]);
+    __m256i bit_pos, mask, words;
+
+    bit_pos=_mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)Key32), salts), 27);
+    mask=_mm256_sllv_epi32(_mm256_set1_epi32(1), bit_pos);
+    words=_mm256_loadu_si256((const __m256i *)Block);
+
+    // testc is true when every mask bit is also set in words
+    return(0!=_mm256_testc_si256(words, mask));
+
+}   // ProbeBlockAvx2
+
+
+// static initializers can run before libgcc's own cpu probe
+static bool
+DetectAvx2()
+{
+    __builtin_cpu_init();
+    return(0!=__builtin_cpu_supports("avx2"));
+}   // DetectAvx2
+
+static const bool gHasAvx2=DetectAvx2();
+#endif
+
+
+BlockedBloomFilterPolicy::BlockedBloomFilterPolicy(
+    int BitsPerKey)
+    : m_BitsPerKey(0<BitsPerKey ? BitsPerKey : 16)
+{
+}   // BlockedBloomFilterPolicy::BlockedBloomFilterPolicy
+
+
+const char*
+BlockedBloomFilterPolicy::Name() const
+{
+    // leveldb stores the filter meta block under "filter." + Name(),
+    //  tables written with another policy simply have no usable filter
+    return("eleveldb.BlockedBloom");
+}   // BlockedBloomFilterPolicy::Name
+
+
+/**
+ * MurmurHash64A by Austin Appleby (public domain).  leveldb's own
+ *  Hash() is 32 bit and internal to the library.
+ */
+uint64_t
+BlockedBloomFilterPolicy::Hash64(
+    const leveldb::Slice & Key)
+{
+    const uint64_t m=0xc6a4a7935bd1e995ULL;
+    const int r=47;
+    const unsigned char * data=(const unsigned char *)Key.data();
+    size_t len=Key.size();
+    uint64_t h=0x5bd1e9955bd1e995ULL ^ (len * m);
+
+    while (8<=len)
+    {
+        uint64_t k;
+
+        k=(uint64_t)data[0] | ((uint64_t)data[1] << 8)
+            | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24)
+            | ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40)
+            | ((uint64_t)data[6] << 48) | ((uint64_t)data[7] << 56);
+
+        k*=m;
+        k^=k >> r;
+        k*=m;
+
+        h^=k;
+        h*=m;
+
+        data+=8;
+        len-=8;
+    }   // while
+
+    switch(len)
+    {
+        case 7: h^=(uint64_t)data[6] << 48;
+            // fall through
+        case 6: h^=(uint64_t)data[5] << 40;
+            // fall through
+        case 5: h^=(uint64_t)data[4] << 32;
+            // fall through
+        case 4: h^=(uint64_t)data[3] << 24;
+            // fall through
+        case 3: h^=(uint64_t)data[2] << 16;
+            // fall through
+        case 2: h^=(uint64_t)data[1] << 8;
+            // fall through
+        case 1: h^=(uint64_t)data[0];
+            h*=m;
+    }   // switch
+
+    h^=h >> r;
+    h*=m;
+    h^=h >> r;
+
+    return(h);
+
+}   // BlockedBloomFilterPolicy::Hash64
+
+
+void
+BlockedBloomFilterPolicy::CreateFilter(
+    const leveldb::Slice* keys,
+    int n,
+    std::string* dst) const
+{
+    size_t num_blocks, bits, init_size, loop, word;
+    char * array;
+
+    // round total bits up to whole blocks, at least one block
+    bits=(size_t)(0<n ? n : 1) * m_BitsPerKey;
+    num_blocks=(bits + kBlockBytes*8 - 1) / (kBlockBytes*8);
+
+    init_size=dst->size();
+    dst->resize(init_size + num_blocks*kBlockBytes, 0);
+    dst->push_back(kFormatVersion);
+    array=&(*dst)[init_size];
+
+    for (loop=0; loop<(size_t)n; ++loop)
+    {
+        uint64_t hash;
+        uint32_t key32;
+        char * block;
+
+        hash=Hash64(keys[loop]);
+        key32=(uint32_t)hash;
+        block=array + BlockIndex(hash, num_blocks)*kBlockBytes;
+
+        for (word=0; word<kBlockWords; ++word)
+        {
+            uint32_t mask;
+
+            mask=(uint32_t)1 << ((key32 * gBloomSalt[word]) >> 27);
+            EncodeWord(block + word*4, DecodeWord(block + word*4) | mask);
+        }   // for
+    }   // for
+
+    return;
+
+}   // BlockedBloomFilterPolicy::CreateFilter
+
+
+bool
+BlockedBloomFilterPolicy::KeyMayMatch(
+    const leveldb::Slice& key,
+    const leveldb::Slice& filter) const
+{
+    size_t num_blocks;
+    uint64_t hash;
+    uint32_t key32;
+    const char * block;
+
+    // unknown layout or empty: err on the side of reading the block
+    if (filter.size() < kBlockBytes+1
+        || kFormatVersion!=filter[filter.size()-1])
+        return(true);
+
+    num_blocks=(filter.size()-1) / kBlockBytes;
+    hash=Hash64(key);
+    key32=(uint32_t)hash;
+    block=filter.data() + BlockIndex(hash, num_blocks)*kBlockBytes;
+
+#if defined(ELEVELDB_BLOOM_AVX2)
+    if (gHasAvx2)
+        return(ProbeBlockAvx2(block, key32));
+#endif
+
+    return(ProbeBlock(block, key32));
+
+}   // BlockedBloomFilterPolicy::KeyMayMatch
+
+
+const leveldb::FilterPolicy *
+NewBlockedBloomFilterPolicy(
+    int BitsPerKey)
+{
+    return(new BlockedBloomFilterPolicy(BitsPerKey));
+}   // NewBlockedBloomFilterPolicy
+
+} // namespace eleveldb
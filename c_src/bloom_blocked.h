@@ -0,0 +1,80 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#ifndef INCL_BLOOM_BLOCKED_H
+#define INCL_BLOOM_BLOCKED_H
+
+#include <stdint.h>
+#include <string>
+
+#include "leveldb/filter_policy.h"
+#include "leveldb/slice.h"
+
+namespace eleveldb {
+
+/**
+ * Split block bloom filter:  every key maps to exactly one 32 byte
+ *  block and sets one bit in each of the block's eight 32 bit words.
+ *  Blocks are not aligned within the filter string, so a lookup reads
+ *  at most two cache lines instead of one line per probe.  The eight
+ *  word tests map onto one AVX2 register on CPUs that have it.
+ *
+ *  Filter layout:  num_blocks * 32 bytes, then one format byte.
+ */
+class BlockedBloomFilterPolicy : public leveldb::FilterPolicy
+{
+public:
+    static const size_t kBlockBytes = 32;
+    static const size_t kBlockWords = 8;
+    static const char kFormatVersion = 1;
+
+protected:
+    size_t m_BitsPerKey;
+
+public:
+    explicit BlockedBloomFilterPolicy(int BitsPerKey);
+
+    virtual ~BlockedBloomFilterPolicy() {};
+
+    virtual const char* Name() const;
+
+    virtual void CreateFilter(const leveldb::Slice* keys, int n, std::string* dst) const;
+
+    virtual bool KeyMayMatch(const leveldb::Slice& key, const leveldb::Slice& filter) const;
+
+    static uint64_t Hash64(const leveldb::Slice & Key);
+
+private:
+    BlockedBloomFilterPolicy();
+    BlockedBloomFilterPolicy(const BlockedBloomFilterPolicy &);             // nocopy
+    BlockedBloomFilterPolicy & operator=(const BlockedBloomFilterPolicy &); // nocopyassign
+
+};  // class BlockedBloomFilterPolicy
+
+
+// counterpart to leveldb::NewBloomFilterPolicy2(), caller owns result
+const leveldb::FilterPolicy * NewBlockedBloomFilterPolicy(int BitsPerKey);
+
+} // namespace eleveldb
+
+
+#endif  // INCL_BLOOM_BLOCKED_H
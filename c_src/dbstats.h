@@ -0,0 +1,161 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#ifndef INCL_DBSTATS_H
+#define INCL_DBSTATS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#ifndef __ELEVELDB_DETAIL_HPP
+    #include "detail.hpp"
+#endif
+
+
+namespace eleveldb {
+
+inline uint64_t
+NowMicros()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return((uint64_t)tv.tv_sec*1000000 + tv.tv_usec);
+}   // NowMicros
+
+
+// for intervals, NowMicros() steps whenever the wall clock is set
+inline uint64_t
+MonotonicMicros()
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000);
+#else
+    return(NowMicros());
+#endif
+}   // MonotonicMicros
+
+
+/**
+ * Latency histogram with power of two microsecond buckets:
+ *  bucket 0 is 0us, bucket N is [2^(N-1), 2^N).  Writers only use
+ *  atomic adds, so a reader can see a sample in m_Count that is
+ *  not yet in its bucket.  Good enough for monitoring.
+ */
+class LatencyHistogram
+{
+public:
+    static const int kBuckets = 32;
+
+    volatile uint64_t m_Count;
+    volatile uint64_t m_TotalMicros;
+    volatile uint64_t m_MaxMicros;
+    volatile uint64_t m_Buckets[kBuckets];
+
+    LatencyHistogram()
+        : m_Count(0), m_TotalMicros(0), m_MaxMicros(0)
+    {
+        memset((void *)m_Buckets, 0, sizeof(m_Buckets));
+    };
+
+    void Add(uint64_t Micros)
+    {
+        int bucket;
+        uint64_t old_max;
+
+        for (bucket=0; bucket<kBuckets-1 && ((uint64_t)1 << bucket)<=Micros; ++bucket)
+        {}
+
+        add_and_fetch(&m_Buckets[bucket], (uint64_t)1);
+        add_and_fetch(&m_TotalMicros, Micros);
+        inc_and_fetch(&m_Count);
+
+        old_max=m_MaxMicros;
+        while (old_max<Micros && !compare_and_swap(&m_MaxMicros, old_max, Micros))
+            old_max=m_MaxMicros;
+    };
+
+    // highest latency counted in bucket Index
+    static uint64_t BucketLimit(int Index)
+    {
+        return(0==Index ? 0 : ((uint64_t)1 << Index) - 1);
+    };
+
+private:
+    LatencyHistogram(const LatencyHistogram &);             // nocopy
+    LatencyHistogram & operator=(const LatencyHistogram &); // nocopyassign
+
+};  // class LatencyHistogram
+
+
+/**
+ * Operation counts for one open database.  leveldb::gPerfCounters
+ *  covers the whole VM, these separate one vnode from another.
+ */
+class DbStats
+{
+public:
+    // eleveldb.cc DB_COUNTER_ATOMS names these, keep the two in order
+    enum CounterEnum
+    {
+        eGets=0,
+        eGetsNotFound=1,
+        eGetErrors=2,
+        eWrites=3,
+        eWriteErrors=4,
+        eIterMoves=5,
+        eBytesRead=6,
+        eBytesWritten=7,
+        eCounterEnumSize=8
+    };
+
+    volatile uint64_t m_Counters[eCounterEnumSize];
+
+    LatencyHistogram m_GetLatency;
+    LatencyHistogram m_WriteLatency;
+    LatencyHistogram m_MoveLatency;
+
+    DbStats()
+    {
+        memset((void *)m_Counters, 0, sizeof(m_Counters));
+    };
+
+    void Add(CounterEnum Counter, uint64_t Amount=1)
+        {add_and_fetch(&m_Counters[Counter], Amount);};
+
+    uint64_t Value(CounterEnum Counter) const {return(m_Counters[Counter]);};
+
+private:
+    DbStats(const DbStats &);             // nocopy
+    DbStats & operator=(const DbStats &); // nocopyassign
+
+};  // class DbStats
+
+} // namespace eleveldb
+
+
+#endif  // INCL_DBSTATS_H
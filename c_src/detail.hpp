@@ -129,6 +129,19 @@ inline size_t dec_and_fetch(volatile size_t *ptr)
 }
 #endif
 
+template <typename ValueT>
+inline ValueT add_and_fetch(volatile ValueT *ptr, ValueT val);
+
+template <>
+inline uint64_t add_and_fetch(volatile uint64_t *ptr, uint64_t val)
+{
+#if ELEVELDB_IS_SOLARIS
+    return atomic_add_64_nv(ptr, val);
+#else
+    return __sync_add_and_fetch(ptr, val);
+#endif
+}
+
 } // namespace eleveldb::detail
 
 #endif
@@ -23,6 +23,7 @@
 #include <syslog.h>
 
 #include <new>
+#include <map>
 #include <set>
 #include <stack>
 #include <deque>
@@ -54,6 +55,18 @@
     #include "atoms.h"
 #endif
 
+#ifndef INCL_BLOOM_BLOCKED_H
+    #include "bloom_blocked.h"
+#endif
+
+#ifndef INCL_SLOWOPS_H
+    #include "slowops.h"
+#endif
+
+#ifndef INCL_STATSPUSH_H
+    #include "statspush.h"
+#endif
+
 #include "work_result.hpp"
 
 #include "detail.hpp"
@@ -63,6 +76,14 @@ static ErlNifFunc nif_funcs[] =
     {"async_close", 2, eleveldb::async_close},
     {"async_iterator_close", 2, eleveldb::async_iterator_close},
     {"status", 2, eleveldb_status},
+    {"db_stats_int", 1, eleveldb_db_stats},
+    {"slow_ops", 0, eleveldb_slow_ops},
+    {"set_slow_op_us", 1, eleveldb_set_slow_op_us},
+    {"set_sample_workers", 1, eleveldb_set_sample_workers},
+    {"worker_sample", 0, eleveldb_worker_sample},
+    {"subscribe_stats", 2, eleveldb_subscribe_stats},
+    {"unsubscribe_stats", 1, eleveldb_unsubscribe_stats},
+    {"memory", 0, eleveldb_memory},
     {"async_destroy", 3, eleveldb::async_destroy},
     {"repair", 2, eleveldb_repair},
     {"is_empty", 1, eleveldb_is_empty},
@@ -120,8 +141,11 @@ ERL_NIF_TERM ATOM_VERIFY_COMPACTIONS;
 ERL_NIF_TERM ATOM_ERROR_DB_DESTROY;
 ERL_NIF_TERM ATOM_KEYS_ONLY;
 ERL_NIF_TERM ATOM_COMPRESSION;
+ERL_NIF_TERM ATOM_SNAPPY;
+ERL_NIF_TERM ATOM_LZ4;
 ERL_NIF_TERM ATOM_ERROR_DB_REPAIR;
 ERL_NIF_TERM ATOM_USE_BLOOMFILTER;
+ERL_NIF_TERM ATOM_BLOCKED;
 ERL_NIF_TERM ATOM_TOTAL_MEMORY;
 ERL_NIF_TERM ATOM_TOTAL_LEVELDB_MEM;
 ERL_NIF_TERM ATOM_TOTAL_LEVELDB_MEM_PERCENT;
@@ -134,6 +158,56 @@ ERL_NIF_TERM ATOM_DELETE_THRESHOLD;
 ERL_NIF_TERM ATOM_TIERED_SLOW_LEVEL;
 ERL_NIF_TERM ATOM_TIERED_FAST_PREFIX;
 ERL_NIF_TERM ATOM_TIERED_SLOW_PREFIX;
+ERL_NIF_TERM ATOM_GETS;
+ERL_NIF_TERM ATOM_GETS_NOT_FOUND;
+ERL_NIF_TERM ATOM_GET_ERRORS;
+ERL_NIF_TERM ATOM_WRITES;
+ERL_NIF_TERM ATOM_WRITE_ERRORS;
+ERL_NIF_TERM ATOM_ITERATOR_MOVES;
+ERL_NIF_TERM ATOM_BYTES_READ;
+ERL_NIF_TERM ATOM_BYTES_WRITTEN;
+ERL_NIF_TERM ATOM_GET_LATENCY;
+ERL_NIF_TERM ATOM_WRITE_LATENCY;
+ERL_NIF_TERM ATOM_MOVE_LATENCY;
+ERL_NIF_TERM ATOM_COUNT;
+ERL_NIF_TERM ATOM_MEAN_US;
+ERL_NIF_TERM ATOM_MAX_US;
+ERL_NIF_TERM ATOM_HISTOGRAM;
+ERL_NIF_TERM ATOM_SLOW_OP_US;
+ERL_NIF_TERM ATOM_TASK;
+ERL_NIF_TERM ATOM_DB;
+ERL_NIF_TERM ATOM_KEY_PREFIX;
+ERL_NIF_TERM ATOM_QUEUE_US;
+ERL_NIF_TERM ATOM_RUN_US;
+ERL_NIF_TERM ATOM_START_US;
+ERL_NIF_TERM ATOM_SAMPLE_WORKERS;
+ERL_NIF_TERM ATOM_THREADS;
+ERL_NIF_TERM ATOM_IDLE;
+ERL_NIF_TERM ATOM_QUEUED;
+ERL_NIF_TERM ATOM_TASKS;
+ERL_NIF_TERM ATOM_DBS;
+ERL_NIF_TERM ATOM_COUNTERS;
+ERL_NIF_TERM ATOM_INTERVAL_US;
+ERL_NIF_TERM ATOM_ELEVELDB_STATS;
+ERL_NIF_TERM ATOM_TOTAL;
+ERL_NIF_TERM ATOM_BLOCK_CACHE;
+ERL_NIF_TERM ATOM_FILE_CACHE;
+ERL_NIF_TERM ATOM_ITERATORS;
+ERL_NIF_TERM ATOM_WRITE_BUFFER_AUTOTUNE;
+ERL_NIF_TERM ATOM_WRITE_BUFFER_SIZE_MIN;
+ERL_NIF_TERM ATOM_WRITE_BUFFER_SIZE_MAX;
+
+ERL_NIF_TERM * const DB_COUNTER_ATOMS[DbStats::eCounterEnumSize]=
+{
+    &ATOM_GETS,             // eGets
+    &ATOM_GETS_NOT_FOUND,   // eGetsNotFound
+    &ATOM_GET_ERRORS,       // eGetErrors
+    &ATOM_WRITES,           // eWrites
+    &ATOM_WRITE_ERRORS,     // eWriteErrors
+    &ATOM_ITERATOR_MOVES,   // eIterMoves
+    &ATOM_BYTES_READ,       // eBytesRead
+    &ATOM_BYTES_WRITTEN     // eBytesWritten
+};
 }   // namespace eleveldb
 
 
@@ -184,13 +258,17 @@ struct EleveldbOptions
 
     bool m_LimitedDeveloper;
     bool m_FadviseWillNeed;
+    bool m_SampleWorkers;
+
+    uint64_t m_SlowOpMicros;
 
     EleveldbOptions()
         : m_EleveldbThreads(71),
           m_LeveldbImmThreads(0), m_LeveldbBGWriteThreads(0),
           m_LeveldbOverlapThreads(0), m_LeveldbGroomingThreads(0),
           m_TotalMemPercent(0), m_TotalMem(0),
-          m_LimitedDeveloper(false), m_FadviseWillNeed(false)
+          m_LimitedDeveloper(false), m_FadviseWillNeed(false),
+          m_SampleWorkers(false), m_SlowOpMicros(0)
         {};
 
     void Dump()
@@ -206,6 +284,8 @@ struct EleveldbOptions
 
         syslog(LOG_ERR, "        m_LimitedDeveloper: %s\n", (m_LimitedDeveloper ? "true" : "false"));
         syslog(LOG_ERR, "         m_FadviseWillNeed: %s\n", (m_FadviseWillNeed ? "true" : "false"));
+        syslog(LOG_ERR, "           m_SampleWorkers: %s\n", (m_SampleWorkers ? "true" : "false"));
+        syslog(LOG_ERR, "            m_SlowOpMicros: %llu\n", (unsigned long long)m_SlowOpMicros);
     }   // Dump
 };  // struct EleveldbOptions
 
@@ -217,10 +297,13 @@ class eleveldb_priv_data
 {
 public:
     EleveldbOptions m_Opts;
+    eleveldb::SlowOpLog m_SlowOps;      // before thread_pool, workers hold a pointer
     eleveldb::eleveldb_thread_pool thread_pool;
+    eleveldb::StatsPublisher m_StatsPublisher;  // after thread_pool, stopped first
 
     explicit eleveldb_priv_data(EleveldbOptions & Options)
-    : m_Opts(Options), thread_pool(Options.m_EleveldbThreads)
+    : m_Opts(Options), m_SlowOps(Options.m_SlowOpMicros),
+      thread_pool(Options.m_EleveldbThreads, &m_SlowOps, Options.m_SampleWorkers)
         {}
 
 private:
@@ -283,6 +366,16 @@ ERL_NIF_TERM parse_init_option(ErlNifEnv* env, ERL_NIF_TERM item, EleveldbOption
         {
             opts.m_FadviseWillNeed = (option[1] == eleveldb::ATOM_TRUE);
         }   // else if
+        else if (option[0] == eleveldb::ATOM_SLOW_OP_US)
+        {
+            unsigned long temp;
+            if (enif_get_ulong(env, option[1], &temp))
+                opts.m_SlowOpMicros = temp;
+        }   // else if
+        else if (option[0] == eleveldb::ATOM_SAMPLE_WORKERS)
+        {
+            opts.m_SampleWorkers = (option[1] == eleveldb::ATOM_TRUE);
+        }   // else if
     }
 
     return eleveldb::ATOM_OK;
@@ -345,10 +438,17 @@ ERL_NIF_TERM parse_open_option(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::Optio
         }
         else if (option[0] == eleveldb::ATOM_COMPRESSION)
         {
-            if (option[1] == eleveldb::ATOM_TRUE)
+            // "true" kept as alias for snappy, the historical default.
+            //  Compression type is recorded per block, so switching
+            //  algorithms only impacts newly written .sst files.
+            if (option[1] == eleveldb::ATOM_TRUE || option[1] == eleveldb::ATOM_SNAPPY)
             {
                 opts.compression = leveldb::kSnappyCompression;
             }
+            else if (option[1] == eleveldb::ATOM_LZ4)
+            {
+                opts.compression = leveldb::kLZ4Compression;
+            }
             else
             {
                 opts.compression = leveldb::kNoCompression;
@@ -359,11 +459,22 @@ ERL_NIF_TERM parse_open_option(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::Optio
             // By default, we want to use a 16-bit-per-key bloom filter on a
             // per-table basis. We only disable it if explicitly asked. Alternatively,
             // one can provide a value for # of bits-per-key.
+            // 'blocked' or {blocked, Bits} selects the cache line blocked filter.
             unsigned long bfsize = 16;
+            int bf_arity;
+            const ERL_NIF_TERM* bf_option;
+
             if (option[1] == eleveldb::ATOM_TRUE || enif_get_ulong(env, option[1], &bfsize))
             {
                 opts.filter_policy = leveldb::NewBloomFilterPolicy2(bfsize);
             }
+            else if (option[1] == eleveldb::ATOM_BLOCKED
+                     || (enif_get_tuple(env, option[1], &bf_arity, &bf_option) && 2==bf_arity
+                         && bf_option[0] == eleveldb::ATOM_BLOCKED
+                         && enif_get_ulong(env, bf_option[1], &bfsize)))
+            {
+                opts.filter_policy = eleveldb::NewBlockedBloomFilterPolicy(bfsize);
+            }
         }
         else if (option[0] == eleveldb::ATOM_TOTAL_MEMORY)
         {
@@ -455,6 +566,39 @@ ERL_NIF_TERM parse_open_option(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::Optio
     return eleveldb::ATOM_OK;
 }
 
+/** open options that steer write_buffer_size but are not leveldb::Options
+ */
+struct WriteBufferTuning
+{
+    bool m_Autotune;
+    size_t m_Min;
+    size_t m_Max;
+
+    WriteBufferTuning() : m_Autotune(false), m_Min(0), m_Max(0) {};
+};  // struct WriteBufferTuning
+
+
+ERL_NIF_TERM parse_write_buffer_option(ErlNifEnv* env, ERL_NIF_TERM item, WriteBufferTuning& tuning)
+{
+    int arity;
+    const ERL_NIF_TERM* option;
+    if (enif_get_tuple(env, item, &arity, &option) && 2==arity)
+    {
+        unsigned long value;
+
+        if (option[0] == eleveldb::ATOM_WRITE_BUFFER_AUTOTUNE)
+            tuning.m_Autotune = (option[1] == eleveldb::ATOM_TRUE);
+        else if (option[0] == eleveldb::ATOM_WRITE_BUFFER_SIZE_MIN
+                 && enif_get_ulong(env, option[1], &value))
+            tuning.m_Min = value;
+        else if (option[0] == eleveldb::ATOM_WRITE_BUFFER_SIZE_MAX
+                 && enif_get_ulong(env, option[1], &value))
+            tuning.m_Max = value;
+    }
+
+    return eleveldb::ATOM_OK;
+}
+
 ERL_NIF_TERM parse_read_option(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::ReadOptions& opts)
 {
     int arity;
@@ -485,8 +629,21 @@ ERL_NIF_TERM parse_write_option(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::Writ
     return eleveldb::ATOM_OK;
 }
 
-ERL_NIF_TERM write_batch_item(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::WriteBatch& batch)
+/** write list fold state:  the batch plus key and value bytes for DbStats
+ */
+struct WriteBatchAcc
+{
+    leveldb::WriteBatch & m_Batch;
+    uint64_t m_Bytes;
+
+    explicit WriteBatchAcc(leveldb::WriteBatch & Batch) : m_Batch(Batch), m_Bytes(0) {};
+};  // struct WriteBatchAcc
+
+
+ERL_NIF_TERM write_batch_item(ErlNifEnv* env, ERL_NIF_TERM item, WriteBatchAcc& acc)
 {
+    leveldb::WriteBatch & batch(acc.m_Batch);
+
     int arity;
     const ERL_NIF_TERM* action;
     if (enif_get_tuple(env, item, &arity, &action) ||
@@ -507,6 +664,7 @@ ERL_NIF_TERM write_batch_item(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::WriteB
             leveldb::Slice key_slice((const char*)key.data, key.size);
             leveldb::Slice value_slice((const char*)value.data, value.size);
             batch.Put(key_slice, value_slice);
+            acc.m_Bytes+=key.size + value.size;
             return eleveldb::ATOM_OK;
         }
 
@@ -515,6 +673,7 @@ ERL_NIF_TERM write_batch_item(ErlNifEnv* env, ERL_NIF_TERM item, leveldb::WriteB
         {
             leveldb::Slice key_slice((const char*)key.data, key.size);
             batch.Delete(key_slice);
+            acc.m_Bytes+=key.size;
             return eleveldb::ATOM_OK;
         }
     }
@@ -562,6 +721,12 @@ async_open(
     fold(env, argv[2], parse_open_option, *opts);
     opts->fadvise_willneed = priv.m_Opts.m_FadviseWillNeed;
 
+    // OpenTask sizes the memtable from earlier write rates
+    WriteBufferTuning tuning;
+    fold(env, argv[2], parse_write_buffer_option, tuning);
+    if (!tuning.m_Autotune || 0==tuning.m_Min || tuning.m_Max < tuning.m_Min)
+        tuning.m_Min=tuning.m_Max=0;
+
     // convert total_leveldb_mem to byte count if it arrived as percent
     //  This happens now because there is no guarantee as to when the total_memory
     //  value would be read relative to total_leveldb_mem_percent in the option fold
@@ -591,7 +756,8 @@ async_open(
     opts->limited_developer_mem=priv.m_Opts.m_LimitedDeveloper;
 
     eleveldb::WorkTask *work_item = new eleveldb::OpenTask(env, caller_ref,
-                                                              db_name, opts);
+                                                              db_name, opts,
+                                                              tuning.m_Min, tuning.m_Max);
 
     if(false == priv.thread_pool.submit(work_item))
     {
@@ -637,7 +803,8 @@ async_write(
     leveldb::WriteBatch* batch = new leveldb::WriteBatch;
 
     // Seed the batch's data:
-    ERL_NIF_TERM result = fold(env, argv[2], write_batch_item, *batch);
+    WriteBatchAcc batch_acc(*batch);
+    ERL_NIF_TERM result = fold(env, argv[2], write_batch_item, batch_acc);
     if(eleveldb::ATOM_OK != result)
     {
         return send_reply(env, caller_ref,
@@ -650,7 +817,8 @@ async_write(
     fold(env, argv[3], parse_write_option, *opts);
 
     eleveldb::WorkTask* work_item = new eleveldb::WriteTask(env, caller_ref,
-                                                            db_ptr.get(), batch, opts);
+                                                            db_ptr.get(), batch, opts,
+                                                            batch_acc.m_Bytes);
 
     if(false == priv.thread_pool.submit(work_item))
     {
@@ -1107,6 +1275,399 @@ eleveldb_status(
 }   // eleveldb_status
 
 
+// [{count, N}, {mean_us, N}, {max_us, N}, {histogram, [{UpperUs, N}, ...]}]
+static ERL_NIF_TERM
+latency_to_term(
+    ErlNifEnv* env,
+    const eleveldb::LatencyHistogram & Hist)
+{
+    ERL_NIF_TERM buckets;
+    uint64_t count;
+    int loop;
+
+    // highest bucket first so the list ends up ascending
+    buckets=enif_make_list(env, 0);
+    for (loop=eleveldb::LatencyHistogram::kBuckets-1; 0<=loop; --loop)
+    {
+        if (0!=Hist.m_Buckets[loop])
+            buckets=enif_make_list_cell(env,
+                                        enif_make_tuple2(env,
+                                                         enif_make_uint64(env, eleveldb::LatencyHistogram::BucketLimit(loop)),
+                                                         enif_make_uint64(env, Hist.m_Buckets[loop])),
+                                        buckets);
+    }   // for
+
+    count=Hist.m_Count;
+
+    return enif_make_list4(env,
+                           enif_make_tuple2(env, eleveldb::ATOM_COUNT, enif_make_uint64(env, count)),
+                           enif_make_tuple2(env, eleveldb::ATOM_MEAN_US,
+                                            enif_make_uint64(env, 0!=count ? Hist.m_TotalMicros/count : 0)),
+                           enif_make_tuple2(env, eleveldb::ATOM_MAX_US, enif_make_uint64(env, Hist.m_MaxMicros)),
+                           enif_make_tuple2(env, eleveldb::ATOM_HISTOGRAM, buckets));
+
+}   // latency_to_term
+
+
+/**
+ * Counters since open for one database, see DbStats
+ */
+ERL_NIF_TERM
+eleveldb_db_stats(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb::ReferencePtr<eleveldb::DbObject> db_ptr;
+
+    db_ptr.assign(eleveldb::DbObject::RetrieveDbObject(env, argv[0]));
+
+    if(NULL==db_ptr.get())
+        return enif_make_badarg(env);
+
+    const eleveldb::DbStats & stats=db_ptr->m_Stats;
+    ERL_NIF_TERM items[eleveldb::DbStats::eCounterEnumSize + 3];
+    int counter;
+
+    for (counter=0; counter<eleveldb::DbStats::eCounterEnumSize; ++counter)
+        items[counter]=enif_make_tuple2(env, *eleveldb::DB_COUNTER_ATOMS[counter],
+            enif_make_uint64(env, stats.Value((eleveldb::DbStats::CounterEnum)counter)));
+
+    items[counter++]=enif_make_tuple2(env, eleveldb::ATOM_GET_LATENCY,
+                                      latency_to_term(env, stats.m_GetLatency));
+    items[counter++]=enif_make_tuple2(env, eleveldb::ATOM_WRITE_LATENCY,
+                                      latency_to_term(env, stats.m_WriteLatency));
+    items[counter++]=enif_make_tuple2(env, eleveldb::ATOM_MOVE_LATENCY,
+                                      latency_to_term(env, stats.m_MoveLatency));
+
+    return enif_make_tuple2(env, eleveldb::ATOM_OK,
+                            enif_make_list_from_array(env, items, counter));
+
+}   // eleveldb_db_stats
+
+
+/**
+ * Contents of the slow operation ring, oldest first.  Always
+ *  empty unless slow_op_us was given at load or set_slow_op_us
+ *  turned the log on.
+ */
+ERL_NIF_TERM
+eleveldb_slow_ops(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+    std::vector<eleveldb::SlowOpRecord> records;
+    ERL_NIF_TERM list;
+    size_t loop;
+
+    priv.m_SlowOps.Snapshot(records);
+
+    list=enif_make_list(env, 0);
+    for (loop=records.size(); 0<loop; --loop)
+    {
+        const eleveldb::SlowOpRecord & rec=records[loop-1];
+        ERL_NIF_TERM items[6];
+
+        items[0]=enif_make_tuple2(env, eleveldb::ATOM_TASK, enif_make_atom(env, rec.m_TaskName));
+        items[1]=enif_make_tuple2(env, eleveldb::ATOM_DB, slice_to_binary(env, rec.m_DbName));
+        items[2]=enif_make_tuple2(env, eleveldb::ATOM_KEY_PREFIX, slice_to_binary(env, rec.m_KeyPrefix));
+        items[3]=enif_make_tuple2(env, eleveldb::ATOM_QUEUE_US, enif_make_uint64(env, rec.m_QueueMicros));
+        items[4]=enif_make_tuple2(env, eleveldb::ATOM_RUN_US, enif_make_uint64(env, rec.m_RunMicros));
+        items[5]=enif_make_tuple2(env, eleveldb::ATOM_START_US, enif_make_uint64(env, rec.m_StartTime));
+
+        list=enif_make_list_cell(env, enif_make_list_from_array(env, items, 6), list);
+    }   // for
+
+    return enif_make_tuple2(env, eleveldb::ATOM_OK, list);
+
+}   // eleveldb_slow_ops
+
+
+/**
+ * Runtime override of the slow_op_us load option, 0 turns the log off
+ */
+ERL_NIF_TERM
+eleveldb_set_slow_op_us(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+    unsigned long micros;
+
+    if (!enif_get_ulong(env, argv[0], &micros))
+        return enif_make_badarg(env);
+
+    priv.m_SlowOps.SetThreshold(micros);
+
+    return eleveldb::ATOM_OK;
+
+}   // eleveldb_set_slow_op_us
+
+
+/**
+ * Runtime override of the sample_workers load option
+ */
+ERL_NIF_TERM
+eleveldb_set_sample_workers(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+
+    if (eleveldb::ATOM_TRUE==argv[0])
+        priv.thread_pool.SetSampleWorkers(true);
+    else if (eleveldb::ATOM_FALSE==argv[0])
+        priv.thread_pool.SetSampleWorkers(false);
+    else
+        return enif_make_badarg(env);
+
+    return eleveldb::ATOM_OK;
+
+}   // eleveldb_set_sample_workers
+
+
+/**
+ * One look at what every worker thread is doing right now.  Idle
+ *  and queued are always valid, task and db counts are only filled
+ *  when sample_workers is on.  eleveldb:worker_profile/2
+ *  turns repeated calls into fractions.
+ */
+ERL_NIF_TERM
+eleveldb_worker_sample(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+    std::vector<eleveldb::WorkerSample> busy;
+    std::map<std::string, size_t> tasks, dbs;
+    std::map<std::string, size_t>::const_iterator it;
+    std::vector<eleveldb::WorkerSample>::const_iterator sample;
+    ERL_NIF_TERM task_list, db_list, items[5];
+    size_t threads, idle;
+
+    threads=priv.thread_pool.SampleWorkers(busy, idle);
+
+    for (sample=busy.begin(); busy.end()!=sample; ++sample)
+    {
+        ++tasks[sample->m_TaskName];
+        if (!sample->m_DbName.empty())
+            ++dbs[sample->m_DbName];
+    }   // for
+
+    task_list=enif_make_list(env, 0);
+    for (it=tasks.begin(); tasks.end()!=it; ++it)
+    {
+        ERL_NIF_TERM pair=enif_make_tuple2(env, enif_make_atom(env, it->first.c_str()),
+                                           enif_make_ulong(env, it->second));
+        task_list=enif_make_list_cell(env, pair, task_list);
+    }   // for
+
+    db_list=enif_make_list(env, 0);
+    for (it=dbs.begin(); dbs.end()!=it; ++it)
+    {
+        ERL_NIF_TERM pair=enif_make_tuple2(env, slice_to_binary(env, it->first),
+                                           enif_make_ulong(env, it->second));
+        db_list=enif_make_list_cell(env, pair, db_list);
+    }   // for
+
+    items[0]=enif_make_tuple2(env, eleveldb::ATOM_THREADS, enif_make_ulong(env, threads));
+    items[1]=enif_make_tuple2(env, eleveldb::ATOM_IDLE, enif_make_ulong(env, idle));
+    items[2]=enif_make_tuple2(env, eleveldb::ATOM_QUEUED,
+                              enif_make_ulong(env, priv.thread_pool.work_queue_depth()));
+    items[3]=enif_make_tuple2(env, eleveldb::ATOM_TASKS, task_list);
+    items[4]=enif_make_tuple2(env, eleveldb::ATOM_DBS, db_list);
+
+    return enif_make_tuple2(env, eleveldb::ATOM_OK, enif_make_list_from_array(env, items, 5));
+
+}   // eleveldb_worker_sample
+
+
+/**
+ * Start pushing {eleveldb_stats, Deltas} to Pid every IntervalMs,
+ *  see StatsSubscription for the message layout.
+ */
+ERL_NIF_TERM
+eleveldb_subscribe_stats(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+    ErlNifPid pid;
+    unsigned long interval_ms;
+
+    if (!enif_get_local_pid(env, argv[0], &pid)
+        || !enif_get_ulong(env, argv[1], &interval_ms) || 0==interval_ms)
+        return enif_make_badarg(env);
+
+    if (!priv.m_StatsPublisher.Subscribe(pid, interval_ms, priv.thread_pool))
+        return enif_make_tuple2(env, eleveldb::ATOM_ERROR, eleveldb::ATOM_EINVAL);
+
+    return eleveldb::ATOM_OK;
+
+}   // eleveldb_subscribe_stats
+
+
+ERL_NIF_TERM
+eleveldb_unsubscribe_stats(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+    ErlNifPid pid;
+
+    if (!enif_get_local_pid(env, argv[0], &pid))
+        return enif_make_badarg(env);
+
+    priv.m_StatsPublisher.Unsubscribe(pid);
+
+    return eleveldb::ATOM_OK;
+
+}   // eleveldb_unsubscribe_stats
+
+
+/**
+ * Memory figures leveldb exposes through GetProperty.  Builds that
+ *  do not know a property simply leave it out of the memory() reply.
+ *  The basho fork has no "leveldb.approximate-memory-usage", so
+ *  memtables are covered only by the write_buffer_size budget.
+ */
+static const struct
+{
+    const char * m_Property;
+    ERL_NIF_TERM * m_Atom;
+} gMemoryProperties[] =
+{
+    {"leveldb.block-cache", &eleveldb::ATOM_BLOCK_CACHE},
+    {"leveldb.file-cache", &eleveldb::ATOM_FILE_CACHE}
+};
+
+static const size_t gMemoryPropertyCount=sizeof(gMemoryProperties)/sizeof(gMemoryProperties[0]);
+
+
+/**
+ * Where memory goes, per open database and summed.  leveldb figures
+ *  are bytes, iterators and tasks are counts since their memory is
+ *  owned by leveldb and the Erlang VM respectively.
+ */
+ERL_NIF_TERM
+eleveldb_memory(
+    ErlNifEnv* env,
+    int argc,
+    const ERL_NIF_TERM argv[])
+{
+    eleveldb_priv_data& priv = *static_cast<eleveldb_priv_data *>(enif_priv_data(env));
+    std::set<eleveldb::DbObject *>::iterator it;
+    std::vector<eleveldb::DbObject *> dbs;
+    std::vector<eleveldb::DbObject *>::iterator db_it;
+    std::vector<ERL_NIF_TERM> items;
+    uint64_t prop_total[gMemoryPropertyCount], write_buffers, iterators, value;
+    bool prop_seen[gMemoryPropertyCount];
+    ERL_NIF_TERM db_list, name;
+    std::string text;
+    size_t loop, itr_count;
+
+    memset(prop_total, 0, sizeof(prop_total));
+    memset(prop_seen, 0, sizeof(prop_seen));
+    write_buffers=0;
+    iterators=0;
+    db_list=enif_make_list(env, 0);
+
+    // GetProperty can wait on leveldb's own locks, so only take
+    //  references under the registry mutex and query after.  Shutdown()
+    //  drops a database from the registry before InitiateCloseRequest()
+    //  waits for extra references, so the closer always holds the last
+    //  one and the RefDec below never runs ~DbObject on this thread.
+    {
+        eleveldb::MutexLock lock(eleveldb::DbObject::m_RegistryMutex);
+
+        dbs.reserve(eleveldb::DbObject::m_Registry.size());
+        for (it=eleveldb::DbObject::m_Registry.begin();
+             eleveldb::DbObject::m_Registry.end()!=it; ++it)
+        {
+            if (0==(*it)->m_CloseRequested)
+            {
+                (*it)->RefInc();
+                dbs.push_back(*it);
+            }   // if
+        }   // for
+    }
+
+    for (db_it=dbs.begin(); dbs.end()!=db_it; ++db_it)
+    {
+        eleveldb::DbObject * db_ptr=*db_it;
+
+        items.clear();
+
+        for (loop=0; NULL!=db_ptr->m_Db && loop<gMemoryPropertyCount; ++loop)
+        {
+            if (db_ptr->m_Db->GetProperty(gMemoryProperties[loop].m_Property, &text))
+            {
+                value=strtoull(text.c_str(), NULL, 10);
+                items.push_back(enif_make_tuple2(env, *gMemoryProperties[loop].m_Atom,
+                                                 enif_make_uint64(env, value)));
+                prop_total[loop]+=value;
+                prop_seen[loop]=true;
+            }   // if
+        }   // for
+
+        if (NULL!=db_ptr->m_DbOptions)
+        {
+            value=db_ptr->m_DbOptions->write_buffer_size;
+            items.push_back(enif_make_tuple2(env, eleveldb::ATOM_WRITE_BUFFER_SIZE,
+                                             enif_make_uint64(env, value)));
+            write_buffers+=value;
+        }   // if
+
+        {
+            eleveldb::MutexLock itr_lock(db_ptr->m_ItrMutex);
+            itr_count=db_ptr->m_ItrList.size();
+        }
+        items.push_back(enif_make_tuple2(env, eleveldb::ATOM_ITERATORS,
+                                         enif_make_ulong(env, itr_count)));
+        iterators+=itr_count;
+
+        name=slice_to_binary(env, db_ptr->m_DbName);
+        db_list=enif_make_list_cell(env,
+                                    enif_make_tuple2(env, name,
+                                                     enif_make_list_from_array(env, &items[0], items.size())),
+                                    db_list);
+
+        // wakes a close waiting on this reference
+        db_ptr->RefDec();
+    }   // for
+
+    items.clear();
+    for (loop=0; loop<gMemoryPropertyCount; ++loop)
+    {
+        if (prop_seen[loop])
+            items.push_back(enif_make_tuple2(env, *gMemoryProperties[loop].m_Atom,
+                                             enif_make_uint64(env, prop_total[loop])));
+    }   // for
+    items.push_back(enif_make_tuple2(env, eleveldb::ATOM_WRITE_BUFFER_SIZE,
+                                     enif_make_uint64(env, write_buffers)));
+    items.push_back(enif_make_tuple2(env, eleveldb::ATOM_ITERATORS,
+                                     enif_make_uint64(env, iterators)));
+    items.push_back(enif_make_tuple2(env, eleveldb::ATOM_TASKS,
+                                     enif_make_uint(env, eleveldb::WorkTask::m_LiveTasks)));
+    items.push_back(enif_make_tuple2(env, eleveldb::ATOM_QUEUED,
+                                     enif_make_ulong(env, priv.thread_pool.work_queue_depth())));
+
+    return enif_make_tuple2(env, eleveldb::ATOM_OK,
+                            enif_make_list2(env,
+                                            enif_make_tuple2(env, eleveldb::ATOM_TOTAL,
+                                                             enif_make_list_from_array(env, &items[0], items.size())),
+                                            enif_make_tuple2(env, eleveldb::ATOM_DBS, db_list)));
+
+}   // eleveldb_memory
+
+
 /**
  * HEY YOU ... please make async
  */
@@ -1246,7 +1807,10 @@ try
     ATOM(eleveldb::ATOM_ERROR_DB_REPAIR, "error_db_repair");
     ATOM(eleveldb::ATOM_KEYS_ONLY, "keys_only");
     ATOM(eleveldb::ATOM_COMPRESSION, "compression");
+    ATOM(eleveldb::ATOM_SNAPPY, "snappy");
+    ATOM(eleveldb::ATOM_LZ4, "lz4");
     ATOM(eleveldb::ATOM_USE_BLOOMFILTER, "use_bloomfilter");
+    ATOM(eleveldb::ATOM_BLOCKED, "blocked");
     ATOM(eleveldb::ATOM_TOTAL_MEMORY, "total_memory");
     ATOM(eleveldb::ATOM_TOTAL_LEVELDB_MEM, "total_leveldb_mem");
     ATOM(eleveldb::ATOM_TOTAL_LEVELDB_MEM_PERCENT, "total_leveldb_mem_percent");
@@ -1259,6 +1823,44 @@ try
     ATOM(eleveldb::ATOM_TIERED_SLOW_LEVEL, "tiered_slow_level");
     ATOM(eleveldb::ATOM_TIERED_FAST_PREFIX, "tiered_fast_prefix");
     ATOM(eleveldb::ATOM_TIERED_SLOW_PREFIX, "tiered_slow_prefix");
+    ATOM(eleveldb::ATOM_GETS, "gets");
+    ATOM(eleveldb::ATOM_GETS_NOT_FOUND, "gets_not_found");
+    ATOM(eleveldb::ATOM_GET_ERRORS, "get_errors");
+    ATOM(eleveldb::ATOM_WRITES, "writes");
+    ATOM(eleveldb::ATOM_WRITE_ERRORS, "write_errors");
+    ATOM(eleveldb::ATOM_ITERATOR_MOVES, "iterator_moves");
+    ATOM(eleveldb::ATOM_BYTES_READ, "bytes_read");
+    ATOM(eleveldb::ATOM_BYTES_WRITTEN, "bytes_written");
+    ATOM(eleveldb::ATOM_GET_LATENCY, "get_latency");
+    ATOM(eleveldb::ATOM_WRITE_LATENCY, "write_latency");
+    ATOM(eleveldb::ATOM_MOVE_LATENCY, "move_latency");
+    ATOM(eleveldb::ATOM_COUNT, "count");
+    ATOM(eleveldb::ATOM_MEAN_US, "mean_us");
+    ATOM(eleveldb::ATOM_MAX_US, "max_us");
+    ATOM(eleveldb::ATOM_HISTOGRAM, "histogram");
+    ATOM(eleveldb::ATOM_SLOW_OP_US, "slow_op_us");
+    ATOM(eleveldb::ATOM_TASK, "task");
+    ATOM(eleveldb::ATOM_DB, "db");
+    ATOM(eleveldb::ATOM_KEY_PREFIX, "key_prefix");
+    ATOM(eleveldb::ATOM_QUEUE_US, "queue_us");
+    ATOM(eleveldb::ATOM_RUN_US, "run_us");
+    ATOM(eleveldb::ATOM_START_US, "start_us");
+    ATOM(eleveldb::ATOM_SAMPLE_WORKERS, "sample_workers");
+    ATOM(eleveldb::ATOM_THREADS, "threads");
+    ATOM(eleveldb::ATOM_IDLE, "idle");
+    ATOM(eleveldb::ATOM_QUEUED, "queued");
+    ATOM(eleveldb::ATOM_TASKS, "tasks");
+    ATOM(eleveldb::ATOM_DBS, "dbs");
+    ATOM(eleveldb::ATOM_COUNTERS, "counters");
+    ATOM(eleveldb::ATOM_INTERVAL_US, "interval_us");
+    ATOM(eleveldb::ATOM_ELEVELDB_STATS, "eleveldb_stats");
+    ATOM(eleveldb::ATOM_TOTAL, "total");
+    ATOM(eleveldb::ATOM_BLOCK_CACHE, "block_cache");
+    ATOM(eleveldb::ATOM_FILE_CACHE, "file_cache");
+    ATOM(eleveldb::ATOM_ITERATORS, "iterators");
+    ATOM(eleveldb::ATOM_WRITE_BUFFER_AUTOTUNE, "write_buffer_autotune");
+    ATOM(eleveldb::ATOM_WRITE_BUFFER_SIZE_MIN, "write_buffer_size_min");
+    ATOM(eleveldb::ATOM_WRITE_BUFFER_SIZE_MAX, "write_buffer_size_max");
 #undef ATOM
 
 
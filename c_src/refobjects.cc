@@ -31,6 +31,9 @@
     #include "workitems.h"
 #endif
 
+#include <stdio.h>
+#include <unistd.h>
+
 #include "leveldb/cache.h"
 #include "leveldb/filter_policy.h"
 
@@ -203,6 +206,9 @@ ErlRefObject::RefDec()
  */
 
 ErlNifResourceType * DbObject::m_Db_RESOURCE(NULL);
+volatile uint64_t DbObject::m_NextStatsId(0);
+Mutex DbObject::m_RegistryMutex;
+std::set<DbObject *> DbObject::m_Registry;
 
 
 void
@@ -223,7 +229,9 @@ DbObject::CreateDbObjectType(
 void *
 DbObject::CreateDbObject(
     leveldb::DB * Db,
-    leveldb::Options * DbOptions)
+    leveldb::Options * DbOptions,
+    const std::string & DbName,
+    bool KeepWriteRate)
 {
     DbObject * ret_ptr;
     void * alloc_ptr;
@@ -231,13 +239,21 @@ DbObject::CreateDbObject(
     // the alloc call initializes the reference count to "one"
     alloc_ptr=enif_alloc_resource(m_Db_RESOURCE, sizeof(DbObject *));
 
-    ret_ptr=new DbObject(Db, DbOptions);
+    ret_ptr=new DbObject(Db, DbOptions, DbName);
+    ret_ptr->m_KeepWriteRate=KeepWriteRate;
     *(DbObject **)alloc_ptr=ret_ptr;
 
     // manual reference increase to keep active until "eleveldb_close" called
     ret_ptr->RefInc();
     ret_ptr->m_ErlangThisPtr=(void * volatile *)alloc_ptr;
 
+    // registered only while that reference is held, Shutdown() removes
+    //  it before InitiateCloseRequest() can release the reference
+    {
+        MutexLock lock(m_RegistryMutex);
+        m_Registry.insert(ret_ptr);
+    }
+
     return(alloc_ptr);
 
 }   // DbObject::CreateDbObject
@@ -306,10 +322,115 @@ DbObject::DbObjectResourceCleanup(
 }   // DbObject::DbObjectResourceCleanup
 
 
+/**
+ * Heavy writers get a memtable that fills in about kWriteBufferSeconds,
+ *  fewer and larger level-0 files.  Idle databases sink to Min.
+ */
+size_t
+DbObject::TunedWriteBuffer(
+    const std::string & DbName,
+    size_t Current,
+    size_t Min,
+    size_t Max)
+{
+    double rate, target;
+    size_t ret_size;
+
+    ret_size=Current;
+
+    if (ReadWriteRate(DbName, rate))
+    {
+        target=rate * kWriteBufferSeconds;
+
+        if (target < Min)
+            ret_size=Min;
+        else if (Max < target)
+            ret_size=Max;
+        else
+            ret_size=(size_t)target;
+    }   // if
+
+    return(ret_size);
+
+}   // DbObject::TunedWriteBuffer
+
+
+// inside the database directory, DestroyDB leaves files it does not
+//  know so DestroyTask removes this one after it
+static const char * kWriteRateFile="/ELEVELDB_WRITE_RATE";
+
+
+bool
+DbObject::ReadWriteRate(
+    const std::string & DbName,
+    double & Rate)
+{
+    std::string path(DbName + kWriteRateFile);
+    FILE * file;
+    bool ret_flag;
+
+    ret_flag=false;
+
+    file=fopen(path.c_str(), "r");
+    if (NULL!=file)
+    {
+        ret_flag=(1==fscanf(file, "%lf", &Rate) && 0<=Rate);
+        fclose(file);
+    }   // if
+
+    return(ret_flag);
+
+}   // DbObject::ReadWriteRate
+
+
+/**
+ * Written to a temporary name then renamed, a crash mid write
+ *  leaves the previous rate in place.
+ */
+void
+DbObject::WriteWriteRate(
+    const std::string & DbName,
+    double Rate)
+{
+    std::string path(DbName + kWriteRateFile), temp(path + ".tmp");
+    FILE * file;
+    bool good;
+
+    file=fopen(temp.c_str(), "w");
+    if (NULL!=file)
+    {
+        good=(0<fprintf(file, "%.0f\n", Rate));
+        good=(0==fclose(file)) && good;
+
+        if (!good || 0!=rename(temp.c_str(), path.c_str()))
+            unlink(temp.c_str());
+    }   // if
+
+    return;
+
+}   // DbObject::WriteWriteRate
+
+
+void
+DbObject::RemoveWriteRate(
+    const std::string & DbName)
+{
+    std::string path(DbName + kWriteRateFile);
+
+    unlink(path.c_str());
+
+    return;
+
+}   // DbObject::RemoveWriteRate
+
+
 DbObject::DbObject(
     leveldb::DB * DbPtr,
-    leveldb::Options * Options)
-    : m_Db(DbPtr), m_DbOptions(Options)
+    leveldb::Options * Options,
+    const std::string & DbName)
+    : m_Db(DbPtr), m_DbOptions(Options), m_DbName(DbName),
+      m_StatsId(inc_and_fetch(&m_NextStatsId)), m_OpenMicros(MonotonicMicros()),
+      m_KeepWriteRate(false)
 {
 }   // DbObject::DbObject
 
@@ -317,10 +438,32 @@ DbObject::DbObject(
 // iterators should already be cleared since they hold a reference
 DbObject::~DbObject()
 {
+    uint64_t elapsed;
+
+    // normally gone since Shutdown(), objects that never reached
+    //  CreateDbObject were never registered
+    {
+        MutexLock lock(m_RegistryMutex);
+        m_Registry.erase(this);
+    }
+
     // close the db
     delete m_Db;
     m_Db=NULL;
 
+    // only autotuned databases get the file, and short opens (tests,
+    //  repair, handoff probes) say little about load
+    elapsed=MonotonicMicros() - m_OpenMicros;
+    if (m_KeepWriteRate && kMinRateMicros <= elapsed && !m_DbName.empty())
+    {
+        double rate, prev;
+
+        rate=(m_Stats.Value(DbStats::eBytesWritten) * 1000000.0) / elapsed;
+        if (ReadWriteRate(m_DbName, prev))
+            rate=(prev + rate) / 2;
+        WriteWriteRate(m_DbName, rate);
+    }   // if
+
     if (NULL!=m_DbOptions)
     {
         // Release any cache we explicitly allocated when setting up options
@@ -346,6 +489,13 @@ DbObject::Shutdown()
     bool again;
     ItrObject * itr_ptr;
 
+    // stats readers may RefInc registry members, so leave while the
+    //  construction reference still keeps the refcount above zero
+    {
+        MutexLock lock(m_RegistryMutex);
+        m_Registry.erase(this);
+    }
+
     do
     {
         again=false;
@@ -25,6 +25,8 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <list>
+#include <set>
+#include <string>
 
 #include "leveldb/db.h"
 #include "leveldb/write_batch.h"
@@ -42,6 +44,10 @@
     #include "atoms.h"
 #endif
 
+#ifndef INCL_DBSTATS_H
+    #include "dbstats.h"
+#endif
+
 
 namespace eleveldb {
 
@@ -181,14 +187,34 @@ public:
 
     leveldb::Options * m_DbOptions;
 
+    std::string m_DbName;                     //!< path given to open, for diagnostics
+
     Mutex m_ItrMutex;                         //!< mutex protecting m_ItrList
     std::list<class ItrObject *> m_ItrList;   //!< ItrObjects holding ref count to this
 
+    DbStats m_Stats;                          //!< operation counts for db_stats NIF
+    const uint64_t m_StatsId;                 //!< never reused, unlike "this"
+    const uint64_t m_OpenMicros;              //!< for the write rate recorded at close
+    bool m_KeepWriteRate;                     //!< opened with autotune, update the rate file at close
+
+    // every open DbObject not yet closing, for stats consumers that walk
+    //  all databases.  Members hold their construction reference, so a
+    //  RefInc under m_RegistryMutex is safe
+    static Mutex m_RegistryMutex;
+    static std::set<DbObject *> m_Registry;
+
+    // only opens lasting this long update the write rate file
+    static const uint64_t kMinRateMicros = 60*1000000ULL;
+
+    // autotuned memtable holds about this many seconds of writes
+    static const uint64_t kWriteBufferSeconds = 60;
+
 protected:
     static ErlNifResourceType* m_Db_RESOURCE;
+    static volatile uint64_t m_NextStatsId;
 
 public:
-    DbObject(leveldb::DB * DbPtr, leveldb::Options * Options);
+    DbObject(leveldb::DB * DbPtr, leveldb::Options * Options, const std::string & DbName);
 
     virtual ~DbObject();
 
@@ -201,10 +227,22 @@ public:
 
     static void CreateDbObjectType(ErlNifEnv * Env);
 
-    static void * CreateDbObject(leveldb::DB * Db, leveldb::Options * DbOptions);
+    static void * CreateDbObject(leveldb::DB * Db, leveldb::Options * DbOptions,
+                                 const std::string & DbName, bool KeepWriteRate=false);
 
     static DbObject * RetrieveDbObject(ErlNifEnv * Env, const ERL_NIF_TERM & DbTerm, bool * term_ok=NULL);
 
+    // write_buffer_size for DbName from its write rate history,
+    //  Current if the database has none
+    static size_t TunedWriteBuffer(const std::string & DbName, size_t Current,
+                                   size_t Min, size_t Max);
+
+    // smoothed bytes/second written by earlier opens, kept in a small
+    //  file inside the database directory so it survives restarts
+    static bool ReadWriteRate(const std::string & DbName, double & Rate);
+    static void WriteWriteRate(const std::string & DbName, double Rate);
+    static void RemoveWriteRate(const std::string & DbName);
+
     static void DbObjectResourceCleanup(ErlNifEnv *Env, void * Arg);
 
 private:
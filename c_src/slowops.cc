@@ -0,0 +1,104 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#ifndef INCL_SLOWOPS_H
+    #include "slowops.h"
+#endif
+
+#ifndef INCL_WORKITEMS_H
+    #include "workitems.h"
+#endif
+
+
+namespace eleveldb {
+
+SlowOpLog::SlowOpLog(
+    uint64_t ThresholdMicros)
+    : m_ThresholdMicros(ThresholdMicros), m_Next(0), m_Total(0)
+{
+}   // SlowOpLog::SlowOpLog
+
+
+void
+SlowOpLog::Check(
+    WorkTask & Task,
+    uint64_t StartMicros,
+    uint64_t EndMicros)
+{
+    uint64_t queue_micros, threshold;
+
+    // times are MonotonicMicros().  Tasks submitted before the log
+    //  was enabled have no submit time
+    queue_micros=(0!=Task.m_SubmitMicros && Task.m_SubmitMicros < StartMicros)
+        ? StartMicros - Task.m_SubmitMicros : 0;
+    threshold=m_ThresholdMicros;
+
+    if (0!=threshold && StartMicros <= EndMicros
+        && threshold <= queue_micros + (EndMicros - StartMicros))
+    {
+        SlowOpRecord record;
+        leveldb::Slice key;
+
+        record.m_QueueMicros=queue_micros;
+        record.m_RunMicros=EndMicros - StartMicros;
+        record.m_StartTime=NowMicros() - record.m_RunMicros;
+        record.m_TaskName=Task.TaskName();
+        record.m_DbName=Task.DbName();
+
+        key=Task.TraceKey();
+        record.m_KeyPrefix.assign(key.data(), key.size() < kKeyPrefix ? key.size() : kKeyPrefix);
+
+        MutexLock lock(m_RingMutex);
+
+        if (m_Ring.size() < kRingSize)
+            m_Ring.push_back(record);
+        else
+            m_Ring[m_Next]=record;
+
+        m_Next=(m_Next+1) % kRingSize;
+        ++m_Total;
+    }   // if
+
+    return;
+
+}   // SlowOpLog::Check
+
+
+uint64_t
+SlowOpLog::Snapshot(
+    std::vector<SlowOpRecord> & Records)
+{
+    MutexLock lock(m_RingMutex);
+    size_t loop;
+
+    Records.clear();
+    Records.reserve(m_Ring.size());
+
+    // before the ring wraps m_Next is also m_Ring.size()
+    for (loop=0; loop<m_Ring.size(); ++loop)
+        Records.push_back(m_Ring[(m_Next + loop) % m_Ring.size()]);
+
+    return(m_Total);
+
+}   // SlowOpLog::Snapshot
+
+} // namespace eleveldb
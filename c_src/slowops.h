@@ -0,0 +1,102 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+#ifndef INCL_SLOWOPS_H
+#define INCL_SLOWOPS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifndef INCL_MUTEX_H
+    #include "mutex.h"
+#endif
+
+namespace eleveldb {
+
+class WorkTask;
+
+
+/**
+ * One WorkTask that took longer than the slow_op_us threshold
+ */
+struct SlowOpRecord
+{
+    uint64_t m_StartTime;         //!< wall clock micros when a worker picked it up
+    uint64_t m_QueueMicros;       //!< submit() until a worker picked it up
+    uint64_t m_RunMicros;         //!< time inside WorkTask::operator()
+    const char * m_TaskName;      //!< static string from WorkTask::TaskName()
+    std::string m_DbName;         //!< path given to open, empty if not known
+    std::string m_KeyPrefix;      //!< leading bytes of the key, empty if none
+
+    SlowOpRecord()
+        : m_StartTime(0), m_QueueMicros(0), m_RunMicros(0), m_TaskName("")
+    {};
+};  // struct SlowOpRecord
+
+
+/**
+ * Fixed size ring of the most recent slow operations.  Worker
+ *  threads only take the mutex when a task is actually slow.
+ */
+class SlowOpLog
+{
+public:
+    static const size_t kRingSize = 256;
+    static const size_t kKeyPrefix = 32;
+
+protected:
+    volatile uint64_t m_ThresholdMicros; //!< 0 disables the log
+
+    Mutex m_RingMutex;                   //!< protects remaining members
+    std::vector<SlowOpRecord> m_Ring;
+    size_t m_Next;                       //!< slot for next record
+    uint64_t m_Total;                    //!< records ever added
+
+public:
+    explicit SlowOpLog(uint64_t ThresholdMicros);
+
+    bool Enabled() const {return(0!=m_ThresholdMicros);};
+
+    uint64_t Threshold() const {return(m_ThresholdMicros);};
+
+    // change the threshold while running, 0 disables
+    void SetThreshold(uint64_t Micros) {m_ThresholdMicros=Micros;};
+
+    // called on worker thread after the task ran, records it if slow
+    // StartMicros and EndMicros from MonotonicMicros()
+    void Check(WorkTask & Task, uint64_t StartMicros, uint64_t EndMicros);
+
+    // copies records oldest first, returns count ever recorded
+    uint64_t Snapshot(std::vector<SlowOpRecord> & Records);
+
+private:
+    SlowOpLog();
+    SlowOpLog(const SlowOpLog &);             // nocopy
+    SlowOpLog & operator=(const SlowOpLog &); // nocopyassign
+
+};  // class SlowOpLog
+
+} // namespace eleveldb
+
+
+#endif  // INCL_SLOWOPS_H
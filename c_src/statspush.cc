@@ -0,0 +1,365 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include <set>
+
+#include "leveldb/perf_count.h"
+
+#ifndef INCL_STATSPUSH_H
+    #include "statspush.h"
+#endif
+
+#ifndef INCL_THREADING_H
+    #include "threading.h"
+#endif
+
+#ifndef INCL_REFOBJECTS_H
+    #include "refobjects.h"
+#endif
+
+#ifndef ATOMS_H
+    #include "atoms.h"
+#endif
+
+
+namespace eleveldb {
+
+static void *
+StatsThread(
+    void * Arg)
+{
+    ((StatsSubscription *)Arg)->Run();
+
+    return(NULL);
+
+}   // StatsThread
+
+
+// local pids are immediate terms, so the words compare directly
+static bool
+SamePid(
+    const ErlNifPid & Lhs,
+    const ErlNifPid & Rhs)
+{
+    return(Lhs.pid==Rhs.pid);
+
+}   // SamePid
+
+
+StatsSubscription::StatsSubscription(
+    const ErlNifPid & Pid,
+    uint64_t IntervalMs,
+    eleveldb_thread_pool & Pool)
+    : m_Pid(Pid), m_IntervalMs(IntervalMs), m_Pool(Pool),
+      m_Stop(false), m_Finished(false), m_LastMicros(0)
+{
+    pthread_mutex_init(&m_Mutex, NULL);
+    pthread_cond_init(&m_Condition, NULL);
+
+}   // StatsSubscription::StatsSubscription
+
+
+StatsSubscription::~StatsSubscription()
+{
+    pthread_cond_destroy(&m_Condition);
+    pthread_mutex_destroy(&m_Mutex);
+
+}   // StatsSubscription::~StatsSubscription
+
+
+void
+StatsSubscription::Stop()
+{
+    pthread_mutex_lock(&m_Mutex);
+    m_Stop=true;
+    pthread_cond_broadcast(&m_Condition);
+    pthread_mutex_unlock(&m_Mutex);
+
+}   // StatsSubscription::Stop
+
+
+void
+StatsSubscription::Run()
+{
+    ErlNifEnv * env;
+    bool alive;
+    struct timespec deadline;
+    uint64_t wake_micros;
+    int ret_val;
+
+    env=enif_alloc_env();
+
+    // first pass only records the baseline
+    SendDeltas(env, false);
+    alive=true;
+
+    pthread_mutex_lock(&m_Mutex);
+    while (!m_Stop && alive)
+    {
+        wake_micros=NowMicros() + m_IntervalMs*1000;
+        deadline.tv_sec=wake_micros / 1000000;
+        deadline.tv_nsec=(wake_micros % 1000000) * 1000;
+
+        // only Stop() signals, anything else is spurious
+        do
+        {
+            ret_val=pthread_cond_timedwait(&m_Condition, &m_Mutex, &deadline);
+        } while (!m_Stop && ETIMEDOUT!=ret_val);
+
+        if (!m_Stop)
+        {
+            pthread_mutex_unlock(&m_Mutex);
+            alive=SendDeltas(env, true);
+            pthread_mutex_lock(&m_Mutex);
+        }   // if
+    }   // while
+
+    m_Finished=true;
+    pthread_mutex_unlock(&m_Mutex);
+
+    enif_free_env(env);
+
+    return;
+
+}   // StatsSubscription::Run
+
+
+bool
+StatsSubscription::SendDeltas(
+    ErlNifEnv * Env,
+    bool Send)
+{
+    bool ret_flag(true);
+    uint64_t now, value;
+    size_t loop;
+    int counter, changed;
+    ERL_NIF_TERM counters, dbs, items[4], msg;
+    std::map<uint64_t, DbCounters> current_dbs;
+    std::set<DbObject *>::iterator db_it;
+
+    now=MonotonicMicros();
+
+    // leveldb counters, gauges among them can move backward
+    counters=enif_make_list(Env, 0);
+    if (NULL!=leveldb::gPerfCounters)
+    {
+        m_LastCounters.resize(leveldb::ePerfCountEnumSize, 0);
+
+        for (loop=0; loop<m_LastCounters.size(); ++loop)
+        {
+            value=leveldb::gPerfCounters->Value(loop);
+            if (value!=m_LastCounters[loop])
+            {
+                ERL_NIF_TERM name=enif_make_atom(Env, leveldb::PerformanceCounters::GetNamePtr(loop));
+                ERL_NIF_TERM delta=enif_make_int64(Env, (int64_t)(value - m_LastCounters[loop]));
+
+                counters=enif_make_list_cell(Env, enif_make_tuple2(Env, name, delta), counters);
+                m_LastCounters[loop]=value;
+            }   // if
+        }   // for
+    }   // if
+
+    // per database counters, a database new since last pass starts from zero
+    dbs=enif_make_list(Env, 0);
+    {
+        MutexLock lock(DbObject::m_RegistryMutex);
+
+        for (db_it=DbObject::m_Registry.begin(); DbObject::m_Registry.end()!=db_it; ++db_it)
+        {
+            DbObject * db_ptr=*db_it;
+            DbCounters & cur=current_dbs[db_ptr->m_StatsId];
+            std::map<uint64_t, DbCounters>::const_iterator prev;
+            ERL_NIF_TERM deltas, name;
+            unsigned char * name_buf;
+
+            prev=m_LastDbs.find(db_ptr->m_StatsId);
+            deltas=enif_make_list(Env, 0);
+            changed=0;
+
+            for (counter=0; counter<DbStats::eCounterEnumSize; ++counter)
+            {
+                cur.m_Values[counter]=db_ptr->m_Stats.Value((DbStats::CounterEnum)counter);
+                value=cur.m_Values[counter];
+                if (m_LastDbs.end()!=prev)
+                    value-=prev->second.m_Values[counter];
+
+                if (0!=value)
+                {
+                    ERL_NIF_TERM pair=enif_make_tuple2(Env, *DB_COUNTER_ATOMS[counter],
+                                                       enif_make_uint64(Env, value));
+                    deltas=enif_make_list_cell(Env, pair, deltas);
+                    ++changed;
+                }   // if
+            }   // for
+
+            if (0!=changed)
+            {
+                name_buf=enif_make_new_binary(Env, db_ptr->m_DbName.size(), &name);
+                memcpy(name_buf, db_ptr->m_DbName.data(), db_ptr->m_DbName.size());
+                dbs=enif_make_list_cell(Env, enif_make_tuple2(Env, name, deltas), dbs);
+            }   // if
+        }   // for
+    }
+
+    m_LastDbs.swap(current_dbs);
+
+    if (Send)
+    {
+        items[0]=enif_make_tuple2(Env, ATOM_INTERVAL_US,
+                                  enif_make_uint64(Env, now - m_LastMicros));
+        items[1]=enif_make_tuple2(Env, ATOM_QUEUED,
+                                  enif_make_uint64(Env, m_Pool.work_queue_depth()));
+        items[2]=enif_make_tuple2(Env, ATOM_COUNTERS, counters);
+        items[3]=enif_make_tuple2(Env, ATOM_DBS, dbs);
+
+        msg=enif_make_tuple2(Env, ATOM_ELEVELDB_STATS,
+                             enif_make_list_from_array(Env, items, 4));
+
+        // enif_send clears Env, fails once the process is gone
+        ret_flag=(0!=enif_send(NULL, &m_Pid, Env, msg));
+    }   // if
+    else
+    {
+        enif_clear_env(Env);
+    }   // else
+
+    m_LastMicros=now;
+
+    return(ret_flag);
+
+}   // StatsSubscription::SendDeltas
+
+
+StatsPublisher::~StatsPublisher()
+{
+    MutexLock lock(m_Mutex);
+
+    while (!m_Subscriptions.empty())
+    {
+        Release(m_Subscriptions.front());
+        m_Subscriptions.pop_front();
+    }   // while
+
+}   // StatsPublisher::~StatsPublisher
+
+
+bool
+StatsPublisher::Subscribe(
+    const ErlNifPid & Pid,
+    uint64_t IntervalMs,
+    eleveldb_thread_pool & Pool)
+{
+    MutexLock lock(m_Mutex);
+    std::list<StatsSubscription *>::iterator it;
+    StatsSubscription * sub;
+
+    ReapFinished();
+
+    for (it=m_Subscriptions.begin(); m_Subscriptions.end()!=it; ++it)
+    {
+        if (SamePid((*it)->m_Pid, Pid))
+        {
+            Release(*it);
+            m_Subscriptions.erase(it);
+            break;
+        }   // if
+    }   // for
+
+    sub=new StatsSubscription(Pid, IntervalMs, Pool);
+    if (0!=enif_thread_create(const_cast<char *>("eleveldb_stats"), &sub->m_Tid,
+                              StatsThread, sub, NULL))
+    {
+        delete sub;
+        return(false);
+    }   // if
+
+    m_Subscriptions.push_back(sub);
+
+    return(true);
+
+}   // StatsPublisher::Subscribe
+
+
+bool
+StatsPublisher::Unsubscribe(
+    const ErlNifPid & Pid)
+{
+    MutexLock lock(m_Mutex);
+    std::list<StatsSubscription *>::iterator it;
+    bool ret_flag(false);
+
+    ReapFinished();
+
+    for (it=m_Subscriptions.begin(); m_Subscriptions.end()!=it; ++it)
+    {
+        if (SamePid((*it)->m_Pid, Pid))
+        {
+            Release(*it);
+            m_Subscriptions.erase(it);
+            ret_flag=true;
+            break;
+        }   // if
+    }   // for
+
+    return(ret_flag);
+
+}   // StatsPublisher::Unsubscribe
+
+
+void
+StatsPublisher::Release(
+    StatsSubscription * Sub)
+{
+    Sub->Stop();
+    enif_thread_join(Sub->m_Tid, NULL);
+    delete Sub;
+
+}   // StatsPublisher::Release
+
+
+void
+StatsPublisher::ReapFinished()
+{
+    std::list<StatsSubscription *>::iterator it;
+
+    it=m_Subscriptions.begin();
+    while (m_Subscriptions.end()!=it)
+    {
+        if ((*it)->m_Finished)
+        {
+            Release(*it);
+            it=m_Subscriptions.erase(it);
+        }   // if
+        else
+        {
+            ++it;
+        }   // else
+    }   // while
+
+}   // StatsPublisher::ReapFinished
+
+} // namespace eleveldb
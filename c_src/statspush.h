@@ -0,0 +1,141 @@
+// -------------------------------------------------------------------
+//
+// eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+//
+// Copyright (c) 2011-2014 Basho Technologies, Inc. All Rights Reserved.
+//
+// This file is provided to you under the Apache License,
+// Version 2.0 (the "License"); you may not use this file
+// except in compliance with the License.  You may obtain
+// a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// -------------------------------------------------------------------
+
+
+#ifndef INCL_STATSPUSH_H
+#define INCL_STATSPUSH_H
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <vector>
+#include <pthread.h>
+
+#include "erl_nif.h"
+
+#ifndef INCL_MUTEX_H
+    #include "mutex.h"
+#endif
+
+#ifndef INCL_DBSTATS_H
+    #include "dbstats.h"
+#endif
+
+namespace eleveldb {
+
+class eleveldb_thread_pool;
+
+
+/**
+ * One Erlang process receiving stats deltas.  Owns a thread that
+ *  wakes every m_IntervalMs and sends
+ *    {eleveldb_stats, [{interval_us, N}, {queued, N},
+ *                      {counters, [{Name, Delta}]},
+ *                      {dbs, [{DbName, [{Name, Delta}]}]}]}
+ *  Only non-zero deltas are included.  The thread exits on its own
+ *  once the process is gone.
+ */
+class StatsSubscription
+{
+public:
+    ErlNifPid m_Pid;
+    const uint64_t m_IntervalMs;
+    eleveldb_thread_pool & m_Pool;       //!< for queue depth
+
+    ErlNifTid m_Tid;
+    volatile bool m_Stop;                //!< set by StatsPublisher to end thread
+    volatile bool m_Finished;            //!< set by thread as it exits
+
+    pthread_mutex_t m_Mutex;             //!< for m_Condition
+    pthread_cond_t m_Condition;          //!< wakes thread early to stop
+
+protected:
+    uint64_t m_LastMicros;
+    std::vector<uint64_t> m_LastCounters;    //!< gPerfCounters at last send
+
+    struct DbCounters
+    {
+        uint64_t m_Values[DbStats::eCounterEnumSize];
+    };
+    std::map<uint64_t, DbCounters> m_LastDbs; //!< keyed by DbObject::m_StatsId
+
+public:
+    StatsSubscription(const ErlNifPid & Pid, uint64_t IntervalMs, eleveldb_thread_pool & Pool);
+
+    virtual ~StatsSubscription();
+
+    // body of the subscription thread
+    void Run();
+
+    // wake the thread and ask it to exit, caller still joins
+    void Stop();
+
+protected:
+    // updates the baseline, sends the deltas only if Send.
+    //  returns false once the receiving process is gone
+    bool SendDeltas(ErlNifEnv * Env, bool Send);
+
+private:
+    StatsSubscription();
+    StatsSubscription(const StatsSubscription &);             // nocopy
+    StatsSubscription & operator=(const StatsSubscription &); // nocopyassign
+
+};  // class StatsSubscription
+
+
+/**
+ * All stats subscriptions of the loaded NIF.  One per pid, a
+ *  second subscribe from the same pid replaces the first.
+ */
+class StatsPublisher
+{
+protected:
+    Mutex m_Mutex;                           //!< protects m_Subscriptions
+    std::list<StatsSubscription *> m_Subscriptions;
+
+public:
+    StatsPublisher() {};
+
+    virtual ~StatsPublisher();
+
+    bool Subscribe(const ErlNifPid & Pid, uint64_t IntervalMs, eleveldb_thread_pool & Pool);
+
+    // returns false if Pid had no subscription
+    bool Unsubscribe(const ErlNifPid & Pid);
+
+protected:
+    // stop and join one subscription, m_Mutex held
+    void Release(StatsSubscription * Sub);
+
+    // join threads that ended because their process went away, m_Mutex held
+    void ReapFinished();
+
+private:
+    StatsPublisher(const StatsPublisher &);             // nocopy
+    StatsPublisher & operator=(const StatsPublisher &); // nocopyassign
+
+};  // class StatsPublisher
+
+} // namespace eleveldb
+
+
+#endif  // INCL_STATSPUSH_H
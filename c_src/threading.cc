@@ -35,6 +35,10 @@
     #include "detail.hpp"
 #endif
 
+#ifndef INCL_SLOWOPS_H
+    #include "slowops.h"
+#endif
+
 namespace eleveldb {
 
 void *eleveldb_write_thread_worker(void *args);
@@ -53,9 +57,14 @@ struct ThreadData
     pthread_mutex_t m_Mutex;             //!< mutex for condition variable
     pthread_cond_t m_Condition;          //!< condition for thread waiting
 
+    eleveldb::Mutex m_RunningMutex;      //!< held while m_RunningTask / m_RunningDb change or are read
+    const char * m_RunningTask;          //!< TaskName() of task in progress, NULL when idle or not sampling
+    std::string m_RunningDb;             //!< DbName() copied before the task ran
+
 
     ThreadData(class eleveldb_thread_pool & Pool)
-    : m_ErlTid(NULL), m_Available(0), m_Pool(Pool), m_DirectWork(NULL)
+    : m_ErlTid(NULL), m_Available(0), m_Pool(Pool), m_DirectWork(NULL),
+      m_RunningTask(NULL)
     {
         pthread_mutex_init(&m_Mutex, NULL);
         pthread_cond_init(&m_Condition, NULL);
@@ -127,6 +136,8 @@ eleveldb_thread_pool::FindWaitingThread(
      if (NULL!=item)
      {
          item->RefInc();
+         if (NULL!=m_SlowOps && m_SlowOps->Enabled())
+             item->m_SubmitMicros=MonotonicMicros();
 
          if(shutdown_pending())
          {
@@ -182,10 +193,11 @@ eleveldb_thread_pool::FindWaitingThread(
  }
 
 
-eleveldb_thread_pool::eleveldb_thread_pool(const size_t thread_pool_size)
+eleveldb_thread_pool::eleveldb_thread_pool(const size_t thread_pool_size, SlowOpLog * SlowOps,
+                                           bool SampleWorkers)
     : work_queue_pending(0), work_queue_lock(0),
       work_queue_atomic(0),
-      shutdown(false)
+      shutdown(false), m_SlowOps(SlowOps), m_SampleWorkers(SampleWorkers)
 {
 
     work_queue_pending = enif_cond_create(const_cast<char *>("work_queue_pending"));
@@ -299,6 +311,45 @@ bool eleveldb_thread_pool::drain_thread_pool()
     return rt();
 }
 
+/**
+ * Reads only the copies each worker made before running its task,
+ *  never the task itself:  a close can release the DbObject while
+ *  the task is still running.
+ */
+size_t
+eleveldb_thread_pool::SampleWorkers(
+    std::vector<WorkerSample> & Busy,
+    size_t & Idle)
+{
+    eleveldb::MutexLock l(threads_lock);
+    thread_pool_t::iterator it;
+
+    Busy.clear();
+    Idle=0;
+
+    for (it=threads.begin(); threads.end()!=it; ++it)
+    {
+        if (0!=(*it)->m_Available)
+            ++Idle;
+
+        if (m_SampleWorkers)
+        {
+            eleveldb::MutexLock r((*it)->m_RunningMutex);
+
+            if (NULL!=(*it)->m_RunningTask)
+            {
+                Busy.push_back(WorkerSample());
+                Busy.back().m_TaskName=(*it)->m_RunningTask;
+                Busy.back().m_DbName=(*it)->m_RunningDb;
+            }   // if
+        }   // if
+    }   // for
+
+    return(threads.size());
+
+}   // SampleWorkers
+
+
 bool eleveldb_thread_pool::notify_caller(eleveldb::WorkTask& work_item)
 {
     ErlNifPid pid;
@@ -370,7 +421,38 @@ void *eleveldb_write_thread_worker(void *args)
         //  then loop to test queue again
         if (NULL!=submission)
         {
-            eleveldb_thread_pool::notify_caller(*submission);
+            bool sampled(h.m_SampleWorkers);
+
+            if (sampled)
+            {
+                const char * task_name(submission->TaskName());
+                std::string db_name(submission->DbName());
+
+                eleveldb::MutexLock r(tdata.m_RunningMutex);
+                tdata.m_RunningTask=task_name;
+                tdata.m_RunningDb.swap(db_name);
+            }   // if
+
+            if (NULL!=h.m_SlowOps && h.m_SlowOps->Enabled())
+            {
+                uint64_t start;
+
+                start=MonotonicMicros();
+                eleveldb_thread_pool::notify_caller(*submission);
+                h.m_SlowOps->Check(*submission, start, MonotonicMicros());
+            }   // if
+            else
+            {
+                eleveldb_thread_pool::notify_caller(*submission);
+            }   // else
+
+            if (sampled)
+            {
+                eleveldb::MutexLock r(tdata.m_RunningMutex);
+                tdata.m_RunningTask=NULL;
+                tdata.m_RunningDb.clear();
+            }   // if
+
             if (submission->resubmit())
             {
                 submission->recycle();
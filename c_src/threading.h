@@ -23,6 +23,7 @@
 #define INCL_THREADING_H
 
 #include <deque>
+#include <string>
 #include <vector>
 #include "leveldb/perf_count.h"
 
@@ -42,6 +43,19 @@ const size_t N_THREADS_MAX = 32767;
 // forward declare
 struct ThreadData;
 class WorkTask;
+class SlowOpLog;
+
+
+/**
+ * What one busy worker thread was running when sampled
+ */
+struct WorkerSample
+{
+    const char * m_TaskName;     //!< static string from WorkTask::TaskName()
+    std::string m_DbName;        //!< path given to open, empty if not known
+
+    WorkerSample() : m_TaskName("") {};
+};  // struct WorkerSample
 
 
 class eleveldb_thread_pool
@@ -70,8 +84,12 @@ private:
 
     volatile bool  shutdown;           // should we stop threads and shut down?
 
+    SlowOpLog *    m_SlowOps;          // NULL or owned by eleveldb_priv_data
+    volatile bool  m_SampleWorkers;    // workers publish their current task
+
 public:
-    eleveldb_thread_pool(const size_t thread_pool_size);
+    eleveldb_thread_pool(const size_t thread_pool_size, SlowOpLog * SlowOps=NULL,
+                         bool SampleWorkers=false);
     ~eleveldb_thread_pool();
 
 public:
@@ -85,6 +103,13 @@ public:
     bool resize_thread_pool(const size_t n);
 
     size_t work_queue_size() const { return work_queue.size(); }
+    size_t work_queue_depth() const { return work_queue_atomic; }
+
+    // returns thread count, Idle gets threads parked waiting for work.
+    //  Busy gets one entry per thread running a task, but stays empty
+    //  unless SampleWorkers is on
+    size_t SampleWorkers(std::vector<WorkerSample> & Busy, size_t & Idle);
+    void SetSampleWorkers(bool Flag) {m_SampleWorkers=Flag;};
     bool shutdown_pending() const  { return shutdown; }
     leveldb::PerformanceCounters * perf() const {return(leveldb::gPerfCounters);};
 
@@ -21,6 +21,7 @@
 // -------------------------------------------------------------------
 
 #include <syslog.h>
+#include <unistd.h>
 
 #ifndef __ELEVELDB_DETAIL_HPP
     #include "detail.hpp"
@@ -61,9 +62,14 @@ namespace eleveldb {
  */
 
 
+volatile uint32_t WorkTask::m_LiveTasks(0);
+
+
 WorkTask::WorkTask(ErlNifEnv *caller_env, ERL_NIF_TERM& caller_ref)
-    : terms_set(false), resubmit_work(false)
+    : terms_set(false), resubmit_work(false), m_SubmitMicros(0)
 {
+    inc_and_fetch(&m_LiveTasks);
+
     if (NULL!=caller_env)
     {
         local_env_ = enif_alloc_env();
@@ -83,8 +89,10 @@ WorkTask::WorkTask(ErlNifEnv *caller_env, ERL_NIF_TERM& caller_ref)
 
 
 WorkTask::WorkTask(ErlNifEnv *caller_env, ERL_NIF_TERM& caller_ref, DbObject * DbPtr)
-    : m_DbPtr(DbPtr), terms_set(false), resubmit_work(false)
+    : m_DbPtr(DbPtr), terms_set(false), resubmit_work(false), m_SubmitMicros(0)
 {
+    inc_and_fetch(&m_LiveTasks);
+
     if (NULL!=caller_env)
     {
         local_env_ = enif_alloc_env();
@@ -116,11 +124,24 @@ WorkTask::~WorkTask()
         enif_free_env(env_ptr);
     }   // if
 
+    dec_and_fetch(&m_LiveTasks);
+
     return;
 
 }   // WorkTask::~WorkTask
 
 
+const std::string &
+WorkTask::DbName()
+{
+    static const std::string no_name;
+
+    // CloseTask releases its DbObject while running
+    return(NULL!=m_DbPtr.get() ? m_DbPtr->m_DbName : no_name);
+
+}   // WorkTask::DbName
+
+
 void
 WorkTask::prepare_recycle()
 {
@@ -146,9 +167,12 @@ OpenTask::OpenTask(
     ErlNifEnv* caller_env,
     ERL_NIF_TERM& _caller_ref,
     const std::string& db_name_,
-    leveldb::Options *open_options_)
+    leveldb::Options *open_options_,
+    size_t TuneMin,
+    size_t TuneMax)
     : WorkTask(caller_env, _caller_ref),
-    db_name(db_name_), open_options(open_options_)
+    db_name(db_name_), open_options(open_options_),
+    m_TuneMin(TuneMin), m_TuneMax(TuneMax)
 {
 }   // OpenTask::OpenTask
 
@@ -159,12 +183,18 @@ OpenTask::operator()()
     void * db_ptr_ptr;
     leveldb::DB *db(0);
 
+    // size memtable from this database's write rate in earlier opens,
+    //  here rather than in async_open to keep file reads off the scheduler
+    if (0!=m_TuneMin)
+        open_options->write_buffer_size=DbObject::TunedWriteBuffer(db_name, open_options->write_buffer_size,
+                                                                   m_TuneMin, m_TuneMax);
+
     leveldb::Status status = leveldb::DB::Open(*open_options, db_name, &db);
 
     if(!status.ok())
         return error_tuple(local_env(), ATOM_ERROR_DB_OPEN, status);
 
-    db_ptr_ptr=DbObject::CreateDbObject(db, open_options);
+    db_ptr_ptr=DbObject::CreateDbObject(db, open_options, db_name, 0!=m_TuneMin);
 
     // create a resource reference to send erlang
     ERL_NIF_TERM result = enif_make_resource(local_env(), db_ptr_ptr);
@@ -186,8 +216,10 @@ work_result
 MoveTask::operator()()
 {
     leveldb::Iterator* itr;
+    uint64_t start;
 
     itr=m_ItrWrap->get();
+    start=MonotonicMicros();
 
 
 //
@@ -273,6 +305,13 @@ MoveTask::operator()()
         }   // else
     }   // if
 
+    // prefetch moves count too, they are the bulk of fold work
+    m_DbPtr->m_Stats.m_MoveLatency.Add(MonotonicMicros() - start);
+    m_DbPtr->m_Stats.Add(DbStats::eIterMoves);
+    if (NULL!=itr && itr->Valid())
+        m_DbPtr->m_Stats.Add(DbStats::eBytesRead, itr->key().size()
+                             + (m_ItrWrap->m_KeysOnly ? 0 : itr->value().size()));
+
     // debug syslog(LOG_ERR, "                     MoveItem::operator() %d, %d, %d",
     //              action, m_ItrWrap->m_StillUse, m_ItrWrap->m_HandoffAtomic);
 
@@ -384,6 +423,12 @@ DestroyTask::operator()()
     if(!status.ok())
         return error_tuple(local_env(), ATOM_ERROR_DB_DESTROY, status);
 
+    // DestroyDB skips files it does not know, so its DeleteDir failed
+    //  while the rate file was there.  Only done on success so a
+    //  failed destroy keeps the history
+    DbObject::RemoveWriteRate(db_name);
+    rmdir(db_name.c_str());
+
     return work_result(ATOM_OK);
 
 }   // DestroyTask::operator()
@@ -73,6 +73,10 @@ protected:
     ErlNifPid local_pid;   // maintain for task lifetime (JFW)
 
  public:
+    uint64_t m_SubmitMicros;      //!< set by eleveldb_thread_pool::submit()
+
+    static volatile uint32_t m_LiveTasks;  //!< constructed and not yet destroyed, for memory()
+
 
     WorkTask(ErlNifEnv *caller_env, ERL_NIF_TERM& caller_ref);
 
@@ -92,6 +96,11 @@ protected:
 
     virtual work_result operator()()     = 0;
 
+    // diagnostics for the slow operation log
+    virtual const char * TaskName() const {return("work");};
+    virtual const std::string & DbName();
+    virtual leveldb::Slice TraceKey() const {return(leveldb::Slice());};
+
 private:
  WorkTask();
  WorkTask(const WorkTask &);
@@ -109,15 +118,21 @@ class OpenTask : public WorkTask
 protected:
     std::string         db_name;
     leveldb::Options   *open_options;  // associated with db handle, we don't free it
+    size_t              m_TuneMin;     //!< write_buffer_size autotune range, 0 when off
+    size_t              m_TuneMax;
 
 public:
     OpenTask(ErlNifEnv* caller_env, ERL_NIF_TERM& _caller_ref,
-             const std::string& db_name_, leveldb::Options *open_options_);
+             const std::string& db_name_, leveldb::Options *open_options_,
+             size_t TuneMin=0, size_t TuneMax=0);
 
     virtual ~OpenTask() {};
 
     virtual work_result operator()();
 
+    virtual const char * TaskName() const {return("open");};
+    virtual const std::string & DbName() {return(db_name);};
+
 private:
     OpenTask();
     OpenTask(const OpenTask &);
@@ -136,16 +151,19 @@ class WriteTask : public WorkTask
 protected:
     leveldb::WriteBatch*    batch;
     leveldb::WriteOptions*          options;
+    uint64_t                batch_bytes;   //!< key plus value bytes, for DbStats
 
 public:
 
     WriteTask(ErlNifEnv* _owner_env, ERL_NIF_TERM _caller_ref,
                 DbObject * _db_handle,
                 leveldb::WriteBatch* _batch,
-                leveldb::WriteOptions* _options)
+                leveldb::WriteOptions* _options,
+                uint64_t _batch_bytes=0)
         : WorkTask(_owner_env, _caller_ref, _db_handle),
        batch(_batch),
-       options(_options)
+       options(_options),
+       batch_bytes(_batch_bytes)
     {}
 
     virtual ~WriteTask()
@@ -156,11 +174,27 @@ public:
 
     virtual work_result operator()()
     {
+        uint64_t start;
+
+        start=MonotonicMicros();
         leveldb::Status status = m_DbPtr->m_Db->Write(*options, batch);
+        m_DbPtr->m_Stats.m_WriteLatency.Add(MonotonicMicros() - start);
+
+        if (status.ok())
+        {
+            m_DbPtr->m_Stats.Add(DbStats::eWrites);
+            m_DbPtr->m_Stats.Add(DbStats::eBytesWritten, batch_bytes);
+        }   // if
+        else
+        {
+            m_DbPtr->m_Stats.Add(DbStats::eWriteErrors);
+        }   // else
 
         return (status.ok() ? work_result(ATOM_OK) : work_result(local_env(), ATOM_ERROR_DB_WRITE, status));
     }
 
+    virtual const char * TaskName() const {return("write");};
+
 };  // class WriteTask
 
 
@@ -230,15 +264,31 @@ public:
         ERL_NIF_TERM value_bin;
         BinaryValue value(local_env(), value_bin);
         leveldb::Slice key_slice(m_Key);
+        ErlNifBinary value_data;
+        uint64_t start;
 
+        start=MonotonicMicros();
         leveldb::Status status = m_DbPtr->m_Db->Get(options, key_slice, &value);
+        m_DbPtr->m_Stats.m_GetLatency.Add(MonotonicMicros() - start);
+        m_DbPtr->m_Stats.Add(DbStats::eGets);
 
         if(!status.ok())
+        {
+            // reply stays not_found, but keep real read errors visible
+            m_DbPtr->m_Stats.Add(status.IsNotFound() ? DbStats::eGetsNotFound
+                                                     : DbStats::eGetErrors);
             return work_result(ATOM_NOT_FOUND);
+        }   // if
+
+        if (enif_inspect_binary(local_env(), value_bin, &value_data))
+            m_DbPtr->m_Stats.Add(DbStats::eBytesRead, value_data.size);
 
         return work_result(local_env(), ATOM_OK, value_bin);
     }
 
+    virtual const char * TaskName() const {return("get");};
+    virtual leveldb::Slice TraceKey() const {return(leveldb::Slice(m_Key));};
+
 };  // class GetTask
 
 
@@ -292,6 +342,8 @@ public:
         return work_result(local_env(), ATOM_OK, result);
     }   // operator()
 
+    virtual const char * TaskName() const {return("iterator");};
+
 };  // class IterTask
 
 
@@ -341,6 +393,10 @@ public:
     virtual void prepare_recycle();
     virtual void recycle();
 
+    virtual const char * TaskName() const {return("iterator_move");};
+    virtual leveldb::Slice TraceKey() const
+        {return(SEEK==action ? leveldb::Slice(seek_target) : leveldb::Slice());};
+
 };  // class MoveTask
 
 
@@ -387,6 +443,8 @@ public:
         }   // else
     }
 
+    virtual const char * TaskName() const {return("close");};
+
 };  // class CloseTask
 
 
@@ -437,6 +495,8 @@ public:
         }   // else
     }
 
+    virtual const char * TaskName() const {return("iterator_close");};
+
 };  // class ItrCloseTask
 
 
@@ -458,6 +518,9 @@ public:
 
     virtual work_result operator()();
 
+    virtual const char * TaskName() const {return("destroy");};
+    virtual const std::string & DbName() {return(db_name);};
+
 private:
     DestroyTask();
     DestroyTask(const DestroyTask &);
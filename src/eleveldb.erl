@@ -31,6 +31,15 @@
          fold/4,
          fold_keys/4,
          status/2,
+         db_stats/1,
+         slow_ops/0,
+         set_slow_op_us/1,
+         set_sample_workers/1,
+         worker_sample/0,
+         worker_profile/2,
+         subscribe_stats/2,
+         unsubscribe_stats/1,
+         memory/0,
          destroy/2,
          repair/2,
          is_empty/1]).
@@ -83,14 +92,18 @@ init() ->
 -type open_options() :: [{create_if_missing, boolean()} |
                          {error_if_exists, boolean()} |
                          {write_buffer_size, pos_integer()} |
+                         {write_buffer_autotune, boolean()} |
+                         {write_buffer_size_min, pos_integer()} |
+                         {write_buffer_size_max, pos_integer()} |
                          {block_size, pos_integer()} |                  %% DEPRECATED
                          {sst_block_size, pos_integer()} |
                          {block_restart_interval, pos_integer()} |
                          {block_size_steps, pos_integer()} |
                          {paranoid_checks, boolean()} |
                          {verify_compactions, boolean()} |
-                         {compression, boolean()} |
-                         {use_bloomfilter, boolean() | pos_integer()} |
+                         {compression, boolean() | snappy | lz4} |
+                         {use_bloomfilter, boolean() | pos_integer() |
+                                           blocked | {blocked, pos_integer()}} |
                          {total_memory, pos_integer()} |
                          {total_leveldb_mem, pos_integer()} |
                          {total_leveldb_mem_percent, pos_integer()} |
@@ -250,6 +263,121 @@ status(Ref, Key) ->
 status_int(_Ref, _Key) ->
     erlang:nif_error({error, not_loaded}).
 
+-type latency_stats() :: [{count, non_neg_integer()} |
+                          {mean_us, non_neg_integer()} |
+                          {max_us, non_neg_integer()} |
+                          {histogram, [{UpperUs::non_neg_integer(), pos_integer()}]}].
+
+%% Operation counts and latencies of this database since open.
+%% leveldb.stats and the leveldb perf counters cover every open database,
+%% these separate one vnode from another.
+%% get_errors counts reads that failed for reasons other than a missing
+%% key (I/O errors, corruption); get/3 still answers not_found for them.
+-spec db_stats(db_ref()) -> {ok, [{atom(), non_neg_integer() | latency_stats()}]}.
+db_stats(Ref) ->
+    eleveldb_bump:small(),
+    db_stats_int(Ref).
+
+db_stats_int(_Ref) ->
+    erlang:nif_error({error, not_loaded}).
+
+%% Most recent operations slower than the slow_op_us threshold, oldest
+%% first.  The threshold comes from the slow_op_us application setting
+%% when the NIF loads and can be changed with set_slow_op_us/1.  queue_us is the
+%% wait for a worker thread, run_us the time spent in leveldb.
+-spec slow_ops() -> {ok, [[{task, atom()} |
+                           {db, binary()} |
+                           {key_prefix, binary()} |
+                           {queue_us, non_neg_integer()} |
+                           {run_us, non_neg_integer()} |
+                           {start_us, non_neg_integer()}]]}.
+slow_ops() ->
+    erlang:nif_error({error, not_loaded}).
+
+%% Change the slow operation threshold without reloading the NIF,
+%% 0 turns the log off.
+-spec set_slow_op_us(non_neg_integer()) -> ok.
+set_slow_op_us(_Micros) ->
+    erlang:nif_error({error, not_loaded}).
+
+%% Turn worker task sampling on or off without reloading the NIF.
+-spec set_sample_workers(boolean()) -> ok.
+set_sample_workers(_Flag) ->
+    erlang:nif_error({error, not_loaded}).
+
+%% What the worker threads are doing right now.  idle and queued are
+%% always filled, tasks and dbs count busy threads by work type and
+%% database only while sampling is on, see the sample_workers
+%% application setting and set_sample_workers/1.
+-spec worker_sample() -> {ok, [{threads, non_neg_integer()} |
+                               {idle, non_neg_integer()} |
+                               {queued, non_neg_integer()} |
+                               {tasks, [{atom(), pos_integer()}]} |
+                               {dbs, [{binary(), pos_integer()}]}]}.
+worker_sample() ->
+    erlang:nif_error({error, not_loaded}).
+
+%% Take Samples worker_sample/0 snapshots IntervalMs apart and report
+%% busy, per task and per database values as a fraction of all worker
+%% threads, queued as the mean backlog.
+-spec worker_profile(pos_integer(), non_neg_integer()) ->
+                            [{samples, pos_integer()} |
+                             {threads, non_neg_integer()} |
+                             {busy, float()} |
+                             {queued, float()} |
+                             {tasks, [{atom(), float()}]} |
+                             {dbs, [{binary(), float()}]}].
+worker_profile(Samples, IntervalMs) when Samples > 0 ->
+    Snaps = worker_snapshots(Samples, IntervalMs, []),
+    Slots = lists:sum([proplists:get_value(threads, S) || S <- Snaps]),
+    Idle = lists:sum([proplists:get_value(idle, S) || S <- Snaps]),
+    Queued = lists:sum([proplists:get_value(queued, S) || S <- Snaps]),
+    Share = fun(Key) ->
+                    Counts = lists:foldl(
+                               fun({K, N}, D) -> orddict:update_counter(K, N, D) end,
+                               orddict:new(),
+                               lists:append([proplists:get_value(Key, S) || S <- Snaps])),
+                    [{K, N / max(Slots, 1)} || {K, N} <- Counts]
+            end,
+    [{samples, Samples},
+     {threads, proplists:get_value(threads, hd(Snaps))},
+     {busy, (Slots - Idle) / max(Slots, 1)},
+     {queued, Queued / Samples},
+     {tasks, Share(tasks)},
+     {dbs, Share(dbs)}].
+
+%% A NIF-side thread sends Pid {eleveldb_stats, Stats} every IntervalMs
+%% with the change since the previous message: leveldb perf counters
+%% and per database db_stats/1 counters, non-zero entries only, plus
+%% the current worker queue backlog.  Subscribing again from the same
+%% Pid replaces the interval.  Stops by itself when Pid exits.
+-spec subscribe_stats(pid(), pos_integer()) -> ok | {error, einval}.
+subscribe_stats(_Pid, _IntervalMs) ->
+    erlang:nif_error({error, not_loaded}).
+
+-spec unsubscribe_stats(pid()) -> ok.
+unsubscribe_stats(_Pid) ->
+    erlang:nif_error({error, not_loaded}).
+
+%% Memory use per open database and summed over all of them.
+%% block_cache and file_cache are bytes and only present when the
+%% leveldb build reports them; write_buffer_size is the configured
+%% budget and the only memtable figure, leveldb does not report
+%% actual memtable use; iterators, tasks and queued are counts of open
+%% iterators, live NIF work items and work items waiting for a thread.
+-spec memory() -> {ok, [{total, [{atom(), non_neg_integer()}]} |
+                        {dbs, [{binary(), [{atom(), non_neg_integer()}]}]}]}.
+memory() ->
+    erlang:nif_error({error, not_loaded}).
+
+worker_snapshots(1, _IntervalMs, Acc) ->
+    {ok, Snap} = worker_sample(),
+    [Snap | Acc];
+worker_snapshots(N, IntervalMs, Acc) ->
+    {ok, Snap} = worker_sample(),
+    timer:sleep(IntervalMs),
+    worker_snapshots(N - 1, IntervalMs, [Snap | Acc]).
+
 -spec async_destroy(reference(), string(), open_options()) -> ok.
 async_destroy(_CallerRef, _Name, _Opts) ->
     erlang:nif_error({error, not_loaded}).
@@ -281,13 +409,16 @@ option_types(open) ->
     [{create_if_missing, bool},
      {error_if_exists, bool},
      {write_buffer_size, integer},
+     {write_buffer_autotune, bool},
+     {write_buffer_size_min, integer},
+     {write_buffer_size_max, integer},
      {block_size, integer},                            %% DEPRECATED
      {sst_block_size, integer},
      {block_restart_interval, integer},
      {block_size_steps, integer},
      {paranoid_checks, bool},
      {verify_compactions, bool},
-     {compression, bool},
+     {compression, any},
      {use_bloomfilter, any},
      {total_memory, integer},
      {total_leveldb_mem, integer},
@@ -459,6 +590,200 @@ compression_test_Z() ->
 	Log1Option = MatchCompressOption("/tmp/eleveldb.compress.1/LOG", "1"),
 	?assert(Log0Option =:= match andalso Log1Option =:= match).
 
+compression_lz4_test() -> [{compression_lz4_test_Z(), l} || l <- lists:seq(1, 20)].
+compression_lz4_test_Z() ->
+    CompressibleData = list_to_binary([0 || _X <- lists:seq(1,20)]),
+    os:cmd("rm -rf /tmp/eleveldb.compress.lz4"),
+    {ok, Ref} = open("/tmp/eleveldb.compress.lz4", [{write_buffer_size, 5},
+                                                    {create_if_missing, true},
+                                                    {compression, lz4}]),
+    [ok = ?MODULE:put(Ref, <<I:64/unsigned>>, CompressibleData, [{sync, true}]) ||
+        I <- lists:seq(1,10)],
+    {ok, CompressibleData} = ?MODULE:get(Ref, <<5:64/unsigned>>, []),
+    {ok, Contents} = file:read_file("/tmp/eleveldb.compress.lz4/LOG"),
+    ?assertMatch({match, _}, re:run(Contents, "Options.compression: 2")).
+
+blocked_bloom_test() ->
+    os:cmd("rm -rf /tmp/eleveldb.blocked_bloom.test"),
+    {ok, Ref} = open("/tmp/eleveldb.blocked_bloom.test", [{create_if_missing, true},
+                                                          {write_buffer_size, 5},
+                                                          {use_bloomfilter, {blocked, 10}}]),
+    [ok = ?MODULE:put(Ref, <<I:64/unsigned>>, <<I:64/unsigned>>, []) ||
+        I <- lists:seq(1,100)],
+    [{ok, <<I:64/unsigned>>} = ?MODULE:get(Ref, <<I:64/unsigned>>, []) ||
+        I <- lists:seq(1,100)],
+    not_found = ?MODULE:get(Ref, <<1000:64/unsigned>>, []),
+    {ok, Contents} = file:read_file("/tmp/eleveldb.blocked_bloom.test/LOG"),
+    ?assertMatch({match, _}, re:run(Contents, "Options.filter_policy: eleveldb.BlockedBloom")),
+    ok = close(Ref).
+
+db_stats_test() ->
+    os:cmd("rm -rf /tmp/eleveldb.db_stats.test"),
+    {ok, Ref} = open("/tmp/eleveldb.db_stats.test", [{create_if_missing, true}]),
+    ok = ?MODULE:put(Ref, <<"abc">>, <<"123">>, []),
+    ok = write(Ref, [{put, <<"def">>, <<"456">>}, {delete, <<"abc">>}], []),
+    {ok, <<"456">>} = ?MODULE:get(Ref, <<"def">>, []),
+    not_found = ?MODULE:get(Ref, <<"abc">>, []),
+    [{<<"def">>, <<"456">>}] = fold(Ref, fun(KV, Acc) -> [KV | Acc] end, [], []),
+    {ok, Stats} = db_stats(Ref),
+    ?assertEqual(2, proplists:get_value(gets, Stats)),
+    ?assertEqual(1, proplists:get_value(gets_not_found, Stats)),
+    ?assertEqual(0, proplists:get_value(get_errors, Stats)),
+    ?assertEqual(2, proplists:get_value(writes, Stats)),
+    ?assertEqual(0, proplists:get_value(write_errors, Stats)),
+    ?assertEqual(3+3 + 3+3 + 3, proplists:get_value(bytes_written, Stats)),
+    ?assert(proplists:get_value(iterator_moves, Stats) >= 2),
+    GetLatency = proplists:get_value(get_latency, Stats),
+    ?assertEqual(2, proplists:get_value(count, GetLatency)),
+    ?assertEqual(2, lists:sum([N || {_, N} <- proplists:get_value(histogram, GetLatency)])),
+    ok = close(Ref),
+    ?assertError(badarg, db_stats(Ref)).
+
+slow_ops_test() ->
+    Name = "/tmp/eleveldb.slow_ops.test",
+    os:cmd("rm -rf " ++ Name),
+    {ok, Ref} = open(Name, [{create_if_missing, true}]),
+    ok = set_slow_op_us(1),
+    try
+        ok = ?MODULE:put(Ref, <<"slowkey">>, <<"v">>, []),
+        {ok, <<"v">>} = ?MODULE:get(Ref, <<"slowkey">>, []),
+        {ok, Ops} = slow_ops(),
+        Get = lists:last(Ops),
+        ?assertEqual(get, proplists:get_value(task, Get)),
+        ?assertEqual(list_to_binary(Name), proplists:get_value(db, Get)),
+        ?assertEqual(<<"slowkey">>, proplists:get_value(key_prefix, Get)),
+        ?assert(lists:any(fun(Op) -> proplists:get_value(task, Op) == write end, Ops)),
+
+        %% keys are cut to 32 bytes
+        Long = binary:copy(<<"k">>, 40),
+        not_found = ?MODULE:get(Ref, Long, []),
+        {ok, Ops2} = slow_ops(),
+        ?assertEqual(binary:part(Long, 0, 32),
+                     proplists:get_value(key_prefix, lists:last(Ops2))),
+
+        %% ring keeps the newest 256, oldest first
+        [not_found = ?MODULE:get(Ref, <<"w", N:32>>, []) || N <- lists:seq(1, 300)],
+        {ok, Ring} = slow_ops(),
+        ?assertEqual(256, length(Ring)),
+        ?assertEqual(<<"w", 45:32>>, proplists:get_value(key_prefix, hd(Ring))),
+        ?assertEqual(<<"w", 300:32>>, proplists:get_value(key_prefix, lists:last(Ring)))
+    after
+        ok = set_slow_op_us(0),
+        ok = close(Ref)
+    end.
+
+worker_profile_test() ->
+    Profile = worker_profile(3, 1),
+    ?assertEqual(3, proplists:get_value(samples, Profile)),
+    ?assert(proplists:get_value(threads, Profile) > 0),
+    Busy = proplists:get_value(busy, Profile),
+    ?assert(Busy >= 0.0 andalso Busy =< 1.0).
+
+sample_workers_churn_test() ->
+    Name = "/tmp/eleveldb.sample_churn.test",
+    os:cmd("rm -rf " ++ Name),
+    ok = set_sample_workers(true),
+    Self = self(),
+    Sampler = spawn_link(fun() -> sample_loop(Self, 0) end),
+    try
+        [begin
+             {ok, Ref} = open(Name, [{create_if_missing, true}]),
+             ok = ?MODULE:put(Ref, <<N:32>>, <<"v">>, []),
+             ok = close(Ref)
+         end || N <- lists:seq(1, 50)],
+        Sampler ! stop,
+        receive
+            {sampled, Count} -> ?assert(Count > 0)
+        after 5000 ->
+                erlang:error(sampler_hung)
+        end
+    after
+        ok = set_sample_workers(false)
+    end.
+
+sample_loop(Parent, Count) ->
+    receive
+        stop -> Parent ! {sampled, Count}
+    after 0 ->
+            {ok, Snap} = worker_sample(),
+            [true = is_atom(T) || {T, _} <- proplists:get_value(tasks, Snap)],
+            [true = is_binary(D) || {D, _} <- proplists:get_value(dbs, Snap)],
+            sample_loop(Parent, Count + 1)
+    end.
+
+subscribe_stats_test() ->
+    os:cmd("rm -rf /tmp/eleveldb.subscribe_stats.test"),
+    {ok, Ref} = open("/tmp/eleveldb.subscribe_stats.test", [{create_if_missing, true}]),
+    ok = subscribe_stats(self(), 20),
+    ok = ?MODULE:put(Ref, <<"abc">>, <<"123">>, []),
+    Dbs = receive_db_stats(<<"/tmp/eleveldb.subscribe_stats.test">>, 50),
+    ?assertEqual(1, proplists:get_value(writes, Dbs)),
+    ok = unsubscribe_stats(self()),
+    ok = close(Ref),
+    flush_stats().
+
+receive_db_stats(_Name, 0) ->
+    erlang:error(no_stats);
+receive_db_stats(Name, Tries) ->
+    receive
+        {eleveldb_stats, Stats} ->
+            ?assert(is_integer(proplists:get_value(queued, Stats))),
+            case lists:keyfind(Name, 1, proplists:get_value(dbs, Stats)) of
+                {Name, Deltas} -> Deltas;
+                false -> receive_db_stats(Name, Tries - 1)
+            end
+    after 1000 ->
+            erlang:error(no_stats)
+    end.
+
+flush_stats() ->
+    receive {eleveldb_stats, _} -> flush_stats()
+    after 100 -> ok
+    end.
+
+memory_test() ->
+    os:cmd("rm -rf /tmp/eleveldb.memory.test"),
+    Name = "/tmp/eleveldb.memory.test",
+    {ok, Ref} = open(Name, [{create_if_missing, true}, {write_buffer_size, 4194304}]),
+    {ok, Itr} = iterator(Ref, []),
+    {ok, Mem} = memory(),
+    Db = proplists:get_value(list_to_binary(Name), proplists:get_value(dbs, Mem)),
+    ?assertEqual(1, proplists:get_value(iterators, Db)),
+    ?assert(proplists:get_value(write_buffer_size, Db) > 0),
+    ?assertNot(proplists:is_defined(memtables, Db)),
+    ?assert(proplists:get_value(iterators, proplists:get_value(total, Mem)) >= 1),
+    ok = iterator_close(Itr),
+    ok = close(Ref).
+
+write_buffer_autotune_test() ->
+    Name = "/tmp/eleveldb.autotune.test",
+    Min = 4194304,
+    Max = 33554432,
+    Opts = [{create_if_missing, true}, {write_buffer_size, 8388608},
+            {write_buffer_autotune, true},
+            {write_buffer_size_min, Min}, {write_buffer_size_max, Max}],
+    Tuned = fun(Rate) ->
+                    os:cmd("rm -rf " ++ Name),
+                    ok = filelib:ensure_dir(Name ++ "/"),
+                    case Rate of
+                        none -> ok;
+                        _ -> ok = file:write_file(Name ++ "/ELEVELDB_WRITE_RATE",
+                                                  integer_to_list(Rate))
+                    end,
+                    {ok, Ref} = open(Name, Opts),
+                    {ok, Mem} = memory(),
+                    ok = close(Ref),
+                    Db = proplists:get_value(list_to_binary(Name),
+                                             proplists:get_value(dbs, Mem)),
+                    proplists:get_value(write_buffer_size, Db)
+            end,
+    %% no history keeps the given size, else about 60s of writes, clamped
+    ?assertEqual(8388608, Tuned(none)),
+    ?assertEqual(Min, Tuned(1000)),
+    ?assertEqual(6000000, Tuned(100000)),
+    ?assertEqual(Max, Tuned(1000000)),
+    ok = destroy(Name, []),
+    ?assertNot(filelib:is_file(Name ++ "/ELEVELDB_WRITE_RATE")).
 
 close_test() -> [{close_test_Z(), l} || l <- lists:seq(1, 20)].
 close_test_Z() ->
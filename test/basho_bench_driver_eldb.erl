@@ -1,7 +1,14 @@
-
 -module(basho_bench_driver_eldb).
 
--record(state, { ref }).
+-record(state, { ref,
+                 work_dir,
+                 open_opts,
+                 key_dist,
+                 key_count = 0,
+                 batch_size,
+                 fold_limit,
+                 multi_get_size,
+                 iterator_action }).
 
 -export([new/1,
          run/4]).
@@ -37,33 +44,203 @@ new(Id) ->
             ok
     end,
 
-    case eleveldb:open(WorkDir, [{create_if_missing, true}] ++ Config) of
+    %% Driver side key selection, used instead of basho_bench's
+    %% key_generator when set:
+    %%   keygen              - basho_bench key_generator (default)
+    %%   {sequential, N}     - 0 .. N-1, then wraps
+    %%   {zipfian, N}        - scrambled zipfian over N keys, YCSB style
+    %%   {latest, N}         - writes append new keys, reads are zipfian
+    %%                         skewed toward the most recently written
+    KeyDist = init_key_dist(basho_bench_config:get(eleveldb_key_distribution,
+                                                   keygen)),
+
+    OpenOpts = [{create_if_missing, true}] ++ Config,
+    case eleveldb:open(WorkDir, OpenOpts) of
         {ok, Ref} ->
-            {ok, #state { ref = Ref }};
+            {ok, #state { ref = Ref,
+                          work_dir = WorkDir,
+                          open_opts = OpenOpts,
+                          key_dist = KeyDist,
+                          batch_size = basho_bench_config:get(eleveldb_batch_size, 100),
+                          fold_limit = basho_bench_config:get(eleveldb_fold_limit, 100),
+                          multi_get_size = basho_bench_config:get(eleveldb_multi_get_size, 10),
+                          iterator_action = basho_bench_config:get(eleveldb_iterator_action,
+                                                                   prefetch) }};
         {error, Reason} ->
             {error, Reason}
     end.
 
 run(get, KeyGen, _ValueGen, State) ->
-    Key = iolist_to_binary(KeyGen()),
-    case eleveldb:get(State#state.ref, Key, []) of
+    {Key, State2} = read_key(KeyGen, State),
+    case eleveldb:get(State2#state.ref, Key, []) of
         {ok, _Value} ->
-            {ok, State};
+            {ok, State2};
         not_found ->
-            {ok, State};
+            {ok, State2};
         {error, Reason} ->
-            {error, Reason, State}
+            {error, Reason, State2}
     end;
 run(put, KeyGen, ValueGen, State) ->
     print_status(State#state.ref, 1000),
-    Key = iolist_to_binary(KeyGen()),
-    case eleveldb:put(State#state.ref, Key, ValueGen(), []) of
+    {Key, State2} = write_key(KeyGen, State),
+    case eleveldb:put(State2#state.ref, Key, ValueGen(), []) of
+        ok ->
+            {ok, State2};
+        {error, Reason} ->
+            {error, Reason, State2}
+    end;
+run(delete, KeyGen, _ValueGen, State) ->
+    {Key, State2} = read_key(KeyGen, State),
+    case eleveldb:delete(State2#state.ref, Key, []) of
+        ok ->
+            {ok, State2};
+        {error, Reason} ->
+            {error, Reason, State2}
+    end;
+run(write_batch, KeyGen, ValueGen, State) ->
+    print_status(State#state.ref, 1000),
+    {Updates, State2} = batch_puts(State#state.batch_size, KeyGen, ValueGen,
+                                   State, []),
+    case eleveldb:write(State2#state.ref, Updates, []) of
         ok ->
-            {ok, State};
+            {ok, State2};
         {error, Reason} ->
-            {error, State, Reason}
+            {error, Reason, State2}
+    end;
+run(fold_range, KeyGen, _ValueGen, State) ->
+    %% eleveldb:fold/4 prefetches; stop by throwing once the limit is hit
+    {Start, State2} = read_key(KeyGen, State),
+    Limit = State2#state.fold_limit,
+    Fun = fun(_KV, Count) when Count + 1 >= Limit ->
+                  throw({fold_limit, Count + 1});
+             (_KV, Count) ->
+                  Count + 1
+          end,
+    try eleveldb:fold(State2#state.ref, Fun, 0, [{first_key, Start}]) of
+        _Count ->
+            {ok, State2}
+    catch
+        throw:{fold_limit, _} ->
+            {ok, State2};
+        throw:{iterator_closed, _} ->
+            {error, iterator_closed, State2}
+    end;
+run(iterator_move, KeyGen, _ValueGen, State) ->
+    %% seek, then fold_limit moves with eleveldb_iterator_action
+    %% (next or prefetch)
+    {Start, State2} = read_key(KeyGen, State),
+    {ok, Itr} = eleveldb:iterator(State2#state.ref, []),
+    try move_loop(eleveldb:iterator_move(Itr, Start), Itr,
+                  State2#state.iterator_action, State2#state.fold_limit) of
+        ok ->
+            {ok, State2};
+        {error, Reason} ->
+            {error, Reason, State2}
+    after
+        eleveldb:iterator_close(Itr)
+    end;
+run(multi_get, KeyGen, _ValueGen, State) ->
+    %% all gets in flight at once, then collect, like a riak_kv 2i fetch
+    {Keys, State2} = read_keys(State#state.multi_get_size, KeyGen, State, []),
+    Refs = [begin
+                CallerRef = make_ref(),
+                eleveldb:async_get(CallerRef, State2#state.ref, Key, []),
+                CallerRef
+            end || Key <- Keys],
+    case collect_gets(Refs) of
+        ok ->
+            {ok, State2};
+        {error, Reason} ->
+            {error, Reason, State2}
+    end;
+run(reopen, _KeyGen, _ValueGen, State) ->
+    %% close/open churn as seen during vnode handoff
+    ok = eleveldb:close(State#state.ref),
+    case eleveldb:open(State#state.work_dir, State#state.open_opts) of
+        {ok, Ref} ->
+            {ok, State#state { ref = Ref }};
+        {error, Reason} ->
+            {error, Reason, State}
+    end.
+
+
+%% ====================================================================
+%% Internal functions
+%% ====================================================================
+
+move_loop({error, invalid_iterator}, _Itr, _Action, _Count) ->
+    ok;
+move_loop({error, _}=Error, _Itr, _Action, _Count) ->
+    Error;
+move_loop(_KV, _Itr, _Action, Count) when Count =< 1 ->
+    ok;
+move_loop(_KV, Itr, Action, Count) ->
+    move_loop(eleveldb:iterator_move(Itr, Action), Itr, Action, Count - 1).
+
+collect_gets([]) ->
+    ok;
+collect_gets([Ref | Rest]) ->
+    receive
+        {Ref, {ok, _Value}} ->
+            collect_gets(Rest);
+        {Ref, not_found} ->
+            collect_gets(Rest);
+        {Ref, {error, Reason}} ->
+            %% drain the others so they do not sit in the mailbox
+            _ = collect_gets(Rest),
+            {error, Reason}
     end.
 
+batch_puts(0, _KeyGen, _ValueGen, State, Acc) ->
+    {Acc, State};
+batch_puts(N, KeyGen, ValueGen, State, Acc) ->
+    {Key, State2} = write_key(KeyGen, State),
+    batch_puts(N - 1, KeyGen, ValueGen, State2, [{put, Key, ValueGen()} | Acc]).
+
+read_keys(0, _KeyGen, State, Acc) ->
+    {Acc, State};
+read_keys(N, KeyGen, State, Acc) ->
+    {Key, State2} = read_key(KeyGen, State),
+    read_keys(N - 1, KeyGen, State2, [Key | Acc]).
+
+init_key_dist(keygen) ->
+    keygen;
+init_key_dist({sequential, N}) ->
+    {sequential, N};
+init_key_dist({Type, N}) when Type == zipfian; Type == latest ->
+    {Type, N, eleveldb_zipf:new(N)}.
+
+read_key(KeyGen, #state { key_dist = keygen }=State) ->
+    {iolist_to_binary(KeyGen()), State};
+read_key(_KeyGen, #state { key_dist = {sequential, N}, key_count = C }=State) ->
+    {int_key(C rem N), State#state { key_count = C + 1 }};
+read_key(_KeyGen, #state { key_dist = {zipfian, N, Zipf} }=State) ->
+    {int_key(erlang:phash2(eleveldb_zipf:next(Zipf), N)), State};
+read_key(_KeyGen, #state { key_dist = {latest, _N, Zipf}, key_count = C }=State) ->
+    {int_key(erlang:max(0, C - 1 - latest_rank(Zipf, C, 8))), State}.
+
+%% Rank below C, the keys written so far.  Ranks are drawn over N, so
+%% while C < N redraw out of range ranks rather than clamping them onto
+%% the oldest key; give up on the skew after a few misses.
+latest_rank(_Zipf, C, _Tries) when C =< 1 ->
+    0;
+latest_rank(_Zipf, C, 0) ->
+    random:uniform(C) - 1;
+latest_rank(Zipf, C, Tries) ->
+    case eleveldb_zipf:next(Zipf) of
+        Rank when Rank < C -> Rank;
+        _ -> latest_rank(Zipf, C, Tries - 1)
+    end.
+
+%% latest appends, everything else writes where it would read
+write_key(_KeyGen, #state { key_dist = {latest, _N, _Zipf}, key_count = C }=State) ->
+    {int_key(C), State#state { key_count = C + 1 }};
+write_key(KeyGen, State) ->
+    read_key(KeyGen, State).
+
+%% fixed width so leveldb order matches numeric order
+int_key(N) ->
+    <<N:64/big-unsigned-integer>>.
 
 print_status(Ref, Count) ->
     status_counter(Count, fun() ->
@@ -84,4 +261,3 @@ status_counter(Max, Fun) ->
         0 -> Fun(), ok;
         _ -> ok
     end.
-
@@ -19,6 +19,7 @@ basic_schema_test() ->
     cuttlefish_unit:assert_config(Config, "eleveldb.limited_developer_mem", false),
     cuttlefish_unit:assert_config(Config, "eleveldb.write_buffer_size_min", 31457280),
     cuttlefish_unit:assert_config(Config, "eleveldb.write_buffer_size_max", 62914560),
+    cuttlefish_unit:assert_config(Config, "eleveldb.write_buffer_autotune", false),
     cuttlefish_unit:assert_config(Config, "eleveldb.use_bloomfilter", true),
     cuttlefish_unit:assert_config(Config, "eleveldb.sst_block_size", 4096),
     cuttlefish_unit:assert_config(Config, "eleveldb.block_restart_interval", 16),
@@ -26,8 +27,10 @@ basic_schema_test() ->
     cuttlefish_unit:assert_config(Config, "eleveldb.verify_compaction", true),
     cuttlefish_unit:assert_config(Config, "eleveldb.eleveldb_threads", 71),
     cuttlefish_unit:assert_config(Config, "eleveldb.fadvise_willneed", false),
+    cuttlefish_unit:assert_config(Config, "eleveldb.slow_op_us", 0),
+    cuttlefish_unit:assert_config(Config, "eleveldb.sample_workers", false),
     cuttlefish_unit:assert_config(Config, "eleveldb.delete_threshold", 1000),
-    cuttlefish_unit:assert_config(Config, "eleveldb.compression", true),
+    cuttlefish_unit:assert_config(Config, "eleveldb.compression", snappy),
     cuttlefish_unit:assert_config(Config, "eleveldb.tiered_slow_level", 0),
     cuttlefish_unit:assert_not_configured(Config, "eleveldb.tiered_fast_prefix"),
     cuttlefish_unit:assert_not_configured(Config, "eleveldb.tiered_slow_prefix"),
@@ -50,6 +53,7 @@ override_schema_test() ->
             {["leveldb", "limited_developer_mem"], on},
             {["leveldb", "write_buffer_size_min"], "10MB"},
             {["leveldb", "write_buffer_size_max"], "20MB"},
+            {["leveldb", "write_buffer_size_autotune"], on},
             {["leveldb", "bloomfilter"], off},
             {["leveldb", "block", "size"], "8KB"},
             {["leveldb", "block", "restart_interval"], 8},
@@ -57,6 +61,8 @@ override_schema_test() ->
             {["leveldb", "verify_compaction"], off},
             {["leveldb", "threads"], 7},
             {["leveldb", "fadvise_willneed"], true},
+            {["leveldb", "slow_op_threshold"], 5000},
+            {["leveldb", "sample_workers"], true},
             {["leveldb", "compression"], off},
             {["leveldb", "compaction", "trigger", "tombstone_count"], off},
             {["leveldb", "tiered"], "2"},
@@ -76,6 +82,7 @@ override_schema_test() ->
     cuttlefish_unit:assert_config(Config, "eleveldb.limited_developer_mem", true),
     cuttlefish_unit:assert_config(Config, "eleveldb.write_buffer_size_min", 10485760),
     cuttlefish_unit:assert_config(Config, "eleveldb.write_buffer_size_max", 20971520),
+    cuttlefish_unit:assert_config(Config, "eleveldb.write_buffer_autotune", true),
     cuttlefish_unit:assert_config(Config, "eleveldb.use_bloomfilter", false),
     cuttlefish_unit:assert_config(Config, "eleveldb.sst_block_size", 8192),
     cuttlefish_unit:assert_config(Config, "eleveldb.block_restart_interval", 8),
@@ -83,6 +90,8 @@ override_schema_test() ->
     cuttlefish_unit:assert_config(Config, "eleveldb.verify_compaction", false),
     cuttlefish_unit:assert_config(Config, "eleveldb.eleveldb_threads", 7),
     cuttlefish_unit:assert_config(Config, "eleveldb.fadvise_willneed", true),
+    cuttlefish_unit:assert_config(Config, "eleveldb.slow_op_us", 5000),
+    cuttlefish_unit:assert_config(Config, "eleveldb.sample_workers", true),
     cuttlefish_unit:assert_config(Config, "eleveldb.delete_threshold", 0),
     cuttlefish_unit:assert_config(Config, "eleveldb.compression", false),
     cuttlefish_unit:assert_config(Config, "eleveldb.tiered_slow_level", 2),
@@ -96,10 +105,29 @@ override_schema_test() ->
     cuttlefish_unit:assert_not_configured(Config, "riak_kv.multi_backend"),
     ok.
 
+compression_algorithm_schema_test() ->
+    Conf = [
+            {["leveldb", "compression", "algorithm"], lz4}
+           ],
+    Config = cuttlefish_unit:generate_templated_config(
+        ["../priv/eleveldb.schema"], Conf, context(), predefined_schema()),
+    cuttlefish_unit:assert_config(Config, "eleveldb.compression", lz4),
+    ok.
+
+bloomfilter_type_schema_test() ->
+    Conf = [
+            {["leveldb", "bloomfilter", "type"], blocked}
+           ],
+    Config = cuttlefish_unit:generate_templated_config(
+        ["../priv/eleveldb.schema"], Conf, context(), predefined_schema()),
+    cuttlefish_unit:assert_config(Config, "eleveldb.use_bloomfilter", blocked),
+    ok.
+
 multi_backend_test() ->
     Conf = [
             {["multi_backend", "default", "storage_backend"], leveldb},
-            {["multi_backend", "default", "leveldb", "data_root"], "/data/default_leveldb"}
+            {["multi_backend", "default", "leveldb", "data_root"], "/data/default_leveldb"},
+            {["multi_backend", "default", "leveldb", "write_buffer_size_autotune"], on}
            ],
     Config = cuttlefish_unit:generate_templated_config(
                ["../priv/eleveldb.schema", "../priv/eleveldb_multi.schema", "../test/multi_backend.schema"],
@@ -117,6 +145,7 @@ multi_backend_test() ->
     cuttlefish_unit:assert_config(DefaultBackend, "limited_developer_mem", false),
     cuttlefish_unit:assert_config(DefaultBackend, "write_buffer_size_min", 15728640),
     cuttlefish_unit:assert_config(DefaultBackend, "write_buffer_size_max", 31457280),
+    cuttlefish_unit:assert_config(DefaultBackend, "write_buffer_autotune", true),
     cuttlefish_unit:assert_config(DefaultBackend, "use_bloomfilter", true),
     cuttlefish_unit:assert_config(DefaultBackend, "sst_block_size", 4096),
     cuttlefish_unit:assert_config(DefaultBackend, "block_restart_interval", 16),
@@ -125,6 +154,7 @@ multi_backend_test() ->
     cuttlefish_unit:assert_config(DefaultBackend, "eleveldb_threads", 71),
     cuttlefish_unit:assert_config(DefaultBackend, "fadvise_willneed", false),
     cuttlefish_unit:assert_config(DefaultBackend, "delete_threshold", 1000),
+    cuttlefish_unit:assert_config(DefaultBackend, "compression", snappy),
     ok.
 
 %% this context() represents the substitution variables that rebar
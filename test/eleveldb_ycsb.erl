@@ -0,0 +1,371 @@
+%% -------------------------------------------------------------------
+%%
+%%  eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+%%
+%% Copyright (c) 2010-2013 Basho Technologies, Inc. All Rights Reserved.
+%%
+%% This file is provided to you under the Apache License,
+%% Version 2.0 (the "License"); you may not use this file
+%% except in compliance with the License.  You may obtain
+%% a copy of the License at
+%%
+%%   http://www.apache.org/licenses/LICENSE-2.0
+%%
+%% Unless required by applicable law or agreed to in writing,
+%% software distributed under the License is distributed on an
+%% "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+%% KIND, either express or implied.  See the License for the
+%% specific language governing permissions and limitations
+%% under the License.
+%%
+%% -------------------------------------------------------------------
+
+%% YCSB core workloads A-F run directly against eleveldb, no basho_bench
+%% needed.  Each run loads record_count keys, runs warmup_count
+%% unrecorded operations, then operation_count recorded ones spread
+%% over `clients' processes.  Every client seeds `random' from `seed'
+%% and its index, so key and operation sequences repeat between runs.
+%%
+%%   erl -pa ebin -pa .eunit -eval 'eleveldb_ycsb:run(a, [{clients, 8}])'
+%%
+%% Options (defaults in brackets):
+%%   {dir, Path}                 ["/tmp/eleveldb.ycsb"], removed first
+%%   {record_count, N}           [100000]
+%%   {operation_count, N}        [100000]
+%%   {warmup_count, N}           [10000]
+%%   {clients, N}                [8]
+%%   {value_size, Bytes}         [1000], YCSB's 10 fields of 100 bytes
+%%   {max_scan_length, N}        [100], workload E
+%%   {seed, {A, B, C}}           [{1, 2, 3}]
+%%   {open_options, Opts}        [[]], e.g. cache or compression settings
+%%   {output_dir, Path}          [undefined], writes <op>.hgrm files
+%%
+%% Thread pool size is a load time setting: set the eleveldb
+%% application env eleveldb_threads before eleveldb is first called.
+%%
+%% Latencies are microseconds in log-linear buckets, 32 per power of
+%% two (about 3% error), printed in HdrHistogram's percentile
+%% distribution format.
+
+-module(eleveldb_ycsb).
+
+-export([run/1,
+         run/2]).
+
+-define(SUB_BUCKET_BITS, 5).
+-define(SUB_BUCKETS, 32).
+-define(BUCKET_COUNT, 1056).
+-define(LOAD_BATCH, 100).
+-define(VALUE_HUNK, 1024*1024).
+
+-record(workload, { read = 0,
+                    update = 0,
+                    insert = 0,
+                    scan = 0,
+                    rmw = 0,
+                    dist = zipfian }).
+
+-record(client, { db,
+                  workload,
+                  zipf,
+                  counter,
+                  record_count,
+                  values,
+                  max_scan_length }).
+
+-ifdef(TEST).
+-include_lib("eunit/include/eunit.hrl").
+-endif.
+
+%% ====================================================================
+%% API
+%% ====================================================================
+
+run(Workload) ->
+    run(Workload, []).
+
+run(Workload, Opts) ->
+    Dir = proplists:get_value(dir, Opts, "/tmp/eleveldb.ycsb"),
+    RecordCount = proplists:get_value(record_count, Opts, 100000),
+    OpCount = proplists:get_value(operation_count, Opts, 100000),
+    WarmupCount = proplists:get_value(warmup_count, Opts, 10000),
+    Clients = proplists:get_value(clients, Opts, 8),
+    ValueSize = proplists:get_value(value_size, Opts, 1000),
+    {S1, S2, S3} = proplists:get_value(seed, Opts, {1, 2, 3}),
+    OpenOpts = [{create_if_missing, true}
+                | proplists:get_value(open_options, Opts, [])],
+
+    os:cmd("rm -rf " ++ Dir),
+    {ok, Db} = eleveldb:open(Dir, OpenOpts),
+    try
+        random:seed(S1, S2, S3),
+        Values = value_hunk(),
+        ok = load(Db, 0, RecordCount, {ValueSize, Values}),
+
+        %% next insert key, shared by all clients
+        Counter = ets:new(?MODULE, [public, set]),
+        true = ets:insert(Counter, {insert_key, RecordCount}),
+
+        Client = #client { db = Db,
+                           workload = workload(Workload),
+                           zipf = eleveldb_zipf:new(RecordCount),
+                           counter = Counter,
+                           record_count = RecordCount,
+                           values = {ValueSize, Values},
+                           max_scan_length = proplists:get_value(max_scan_length,
+                                                                 Opts, 100) },
+
+        _ = run_clients(Client, Clients, WarmupCount, {S1, S2, S3}),
+        Start = os:timestamp(),
+        Hists = run_clients(Client, Clients, OpCount, {S1 + 1, S2, S3}),
+        Elapsed = timer:now_diff(os:timestamp(), Start),
+        ets:delete(Counter),
+
+        Merged = merge_hists(Hists),
+        report(Workload, OpCount, Elapsed, Merged,
+               proplists:get_value(output_dir, Opts, undefined))
+    after
+        eleveldb:close(Db)
+    end.
+
+
+%% ====================================================================
+%% Internal functions
+%% ====================================================================
+
+%% YCSB core workload definitions
+workload(a) -> #workload { read = 50, update = 50 };
+workload(b) -> #workload { read = 95, update = 5 };
+workload(c) -> #workload { read = 100 };
+workload(d) -> #workload { read = 95, insert = 5, dist = latest };
+workload(e) -> #workload { scan = 95, insert = 5 };
+workload(f) -> #workload { read = 50, rmw = 50 }.
+
+load(_Db, Next, RecordCount, _Values) when Next >= RecordCount ->
+    ok;
+load(Db, Next, RecordCount, Values) ->
+    Last = erlang:min(Next + ?LOAD_BATCH, RecordCount),
+    Batch = [{put, key(K), value(Values)} || K <- lists:seq(Next, Last - 1)],
+    ok = eleveldb:write(Db, Batch, []),
+    load(Db, Last, RecordCount, Values).
+
+run_clients(Client, Clients, OpCount, {S1, S2, S3}) ->
+    Self = self(),
+    Pids = [spawn_link(
+              fun() ->
+                      random:seed(S1, S2, S3 + Index),
+                      Ops = OpCount div Clients
+                          + (if Index =< OpCount rem Clients -> 1; true -> 0 end),
+                      Self ! {self(), client_loop(Ops, Client, [])}
+              end) || Index <- lists:seq(1, Clients)],
+    [receive {Pid, Hists} -> Hists end || Pid <- Pids].
+
+client_loop(0, _Client, Hists) ->
+    Hists;
+client_loop(N, Client, Hists) ->
+    Op = choose_op(Client#client.workload),
+    Start = os:timestamp(),
+    ok = do_op(Op, Client),
+    Latency = timer:now_diff(os:timestamp(), Start),
+    client_loop(N - 1, Client, hist_add(Op, Latency, Hists)).
+
+choose_op(#workload { read = R, update = U, insert = I, scan = S }) ->
+    case random:uniform(100) of
+        X when X =< R -> read;
+        X when X =< R + U -> update;
+        X when X =< R + U + I -> insert;
+        X when X =< R + U + I + S -> scan;
+        _ -> rmw
+    end.
+
+do_op(read, Client) ->
+    read(Client#client.db, next_key(Client));
+do_op(update, Client) ->
+    eleveldb:put(Client#client.db, next_key(Client),
+                 value(Client#client.values), []);
+do_op(insert, Client) ->
+    K = ets:update_counter(Client#client.counter, insert_key, 1) - 1,
+    eleveldb:put(Client#client.db, key(K), value(Client#client.values), []);
+do_op(scan, Client) ->
+    Limit = random:uniform(Client#client.max_scan_length),
+    Fun = fun(_KV, Count) when Count + 1 >= Limit ->
+                  throw({scan_done, Count + 1});
+             (_KV, Count) ->
+                  Count + 1
+          end,
+    try eleveldb:fold(Client#client.db, Fun, 0, [{first_key, next_key(Client)}]) of
+        _ -> ok
+    catch
+        throw:{scan_done, _} -> ok
+    end;
+do_op(rmw, Client) ->
+    Key = next_key(Client),
+    ok = read(Client#client.db, Key),
+    eleveldb:put(Client#client.db, Key, value(Client#client.values), []).
+
+read(Db, Key) ->
+    case eleveldb:get(Db, Key, []) of
+        {ok, _Value} -> ok;
+        not_found -> ok
+    end.
+
+next_key(#client { workload = #workload { dist = latest }, zipf = Zipf,
+                   counter = Counter }) ->
+    [{insert_key, Next}] = ets:lookup(Counter, insert_key),
+    key(erlang:max(0, Next - 1 - eleveldb_zipf:next(Zipf)));
+next_key(#client { zipf = Zipf, record_count = RecordCount }) ->
+    %% scrambled so the hot keys are not neighbours
+    key(erlang:phash2(eleveldb_zipf:next(Zipf), RecordCount)).
+
+%% ordered inserts: leveldb order is insert order
+key(N) ->
+    <<"user", N:64/big-unsigned-integer>>.
+
+%% printable random bytes made once, values are slices of it so
+%% generating one stays out of the measured latency
+value_hunk() ->
+    list_to_binary([random:uniform(95) + 31 || _ <- lists:seq(1, ?VALUE_HUNK)]).
+
+value({Size, Hunk}) ->
+    Offset = random:uniform(erlang:max(byte_size(Hunk) - Size, 1)) - 1,
+    binary:part(Hunk, Offset, erlang:min(Size, byte_size(Hunk))).
+
+
+%% --------------------------------------------------------------------
+%% Log-linear histogram: values below 2*SUB_BUCKETS are exact, above
+%% that each power of two is split into SUB_BUCKETS linear buckets.
+
+hist_add(Op, Latency, Hists) ->
+    Hist = case lists:keyfind(Op, 1, Hists) of
+               {Op, H} -> H;
+               false -> array:new(?BUCKET_COUNT, {default, 0})
+           end,
+    Index = bucket_index(Latency),
+    lists:keystore(Op, 1, Hists, {Op, array:set(Index, array:get(Index, Hist) + 1, Hist)}).
+
+bucket_index(V) when V < 2 * ?SUB_BUCKETS ->
+    erlang:max(V, 0);
+bucket_index(V) ->
+    Shift = erlang:min(msb(V, 0) - ?SUB_BUCKET_BITS, 31),
+    Mantissa = erlang:min(V bsr Shift, 2 * ?SUB_BUCKETS - 1),
+    2 * ?SUB_BUCKETS + (Shift - 1) * ?SUB_BUCKETS + (Mantissa - ?SUB_BUCKETS).
+
+%% highest value that falls in the bucket
+bucket_value(Index) when Index < 2 * ?SUB_BUCKETS ->
+    Index;
+bucket_value(Index) ->
+    Shift = (Index - 2 * ?SUB_BUCKETS) div ?SUB_BUCKETS + 1,
+    Mantissa = (Index - 2 * ?SUB_BUCKETS) rem ?SUB_BUCKETS + ?SUB_BUCKETS,
+    ((Mantissa + 1) bsl Shift) - 1.
+
+msb(1, Bit) -> Bit;
+msb(V, Bit) -> msb(V bsr 1, Bit + 1).
+
+merge_hists(ClientHists) ->
+    lists:foldl(
+      fun(Hists, Acc) ->
+              lists:foldl(
+                fun({Op, Hist}, Acc2) ->
+                        case lists:keyfind(Op, 1, Acc2) of
+                            {Op, Sum} ->
+                                lists:keystore(Op, 1, Acc2, {Op, add_hist(Sum, Hist)});
+                            false ->
+                                [{Op, Hist} | Acc2]
+                        end
+                end, Acc, Hists)
+      end, [], ClientHists).
+
+add_hist(A, B) ->
+    array:foldl(fun(I, C, Acc) -> array:set(I, array:get(I, Acc) + C, Acc) end, A, B).
+
+%% [{Value, Count}] for non-empty buckets, ascending
+hist_buckets(Hist) ->
+    array:sparse_foldr(fun(I, C, Acc) -> [{bucket_value(I), C} | Acc] end, [], Hist).
+
+percentile(Buckets, Total, Pct) ->
+    Target = erlang:max(1, round(Total * Pct / 100)),
+    percentile(Buckets, Target).
+
+percentile([{Value, _Count}], _Target) ->
+    Value;
+percentile([{Value, Count} | _Rest], Target) when Count >= Target ->
+    Value;
+percentile([{_Value, Count} | Rest], Target) ->
+    percentile(Rest, Target - Count).
+
+summary(Buckets) ->
+    Total = lists:sum([C || {_, C} <- Buckets]),
+    Mean = lists:sum([V * C || {V, C} <- Buckets]) / Total,
+    [{count, Total},
+     {mean_us, Mean},
+     {p50_us, percentile(Buckets, Total, 50)},
+     {p95_us, percentile(Buckets, Total, 95)},
+     {p99_us, percentile(Buckets, Total, 99)},
+     {p999_us, percentile(Buckets, Total, 99.9)},
+     {max_us, element(1, lists:last(Buckets))}].
+
+report(Workload, OpCount, Elapsed, Hists, OutputDir) ->
+    OpsPerSec = OpCount * 1000000 / erlang:max(Elapsed, 1),
+    io:format("workload ~p: ~b ops in ~.3f s, ~.1f ops/sec~n",
+              [Workload, OpCount, Elapsed / 1000000, OpsPerSec]),
+    Summaries =
+        [begin
+             Buckets = hist_buckets(Hist),
+             Summary = summary(Buckets),
+             io:format("  ~-6s ~p~n", [Op, Summary]),
+             write_hgrm(OutputDir, Op, Buckets),
+             {Op, Summary}
+         end || {Op, Hist} <- lists:keysort(1, Hists)],
+    [{workload, Workload},
+     {elapsed_us, Elapsed},
+     {ops_per_sec, OpsPerSec},
+     {ops, Summaries}].
+
+%% HdrHistogram percentile distribution text, loadable by its plotter
+write_hgrm(undefined, _Op, _Buckets) ->
+    ok;
+write_hgrm(OutputDir, Op, Buckets) ->
+    Total = lists:sum([C || {_, C} <- Buckets]),
+    {Lines, _} =
+        lists:mapfoldl(
+          fun({Value, Count}, Seen) ->
+                  Seen2 = Seen + Count,
+                  Fraction = Seen2 / Total,
+                  Inverse = case Fraction < 1.0 of
+                                true -> io_lib:format("~.2f", [1 / (1 - Fraction)]);
+                                false -> "inf"
+                            end,
+                  {io_lib:format("~12.3f ~14.12f ~10b ~14s~n",
+                                 [float(Value), Fraction, Seen2, Inverse]), Seen2}
+          end, 0, Buckets),
+    File = filename:join(OutputDir, atom_to_list(Op) ++ ".hgrm"),
+    ok = filelib:ensure_dir(File),
+    file:write_file(File, ["       Value     Percentile TotalCount 1/(1-Percentile)\n\n"
+                           | Lines]).
+
+
+-ifdef(TEST).
+
+bucket_round_trip_test() ->
+    [?assert(bucket_value(bucket_index(V)) >= V) || V <- [0, 1, 63, 64, 65, 1000, 123456]],
+    %% within one sub bucket, about 3%
+    [?assert(bucket_value(bucket_index(V)) - V =< V div ?SUB_BUCKETS)
+     || V <- [64, 999, 54321, 9876543]].
+
+ycsb_smoke_test_() ->
+    {timeout, 5*60,
+     fun() ->
+             Dir = "/tmp/eleveldb.ycsb.test",
+             [begin
+                  Result = run(W, [{dir, Dir}, {record_count, 1000},
+                                   {operation_count, 1000}, {warmup_count, 100},
+                                   {clients, 4}, {value_size, 100}]),
+                  ?assertEqual(W, proplists:get_value(workload, Result)),
+                  Ops = proplists:get_value(ops, Result),
+                  ?assertEqual(1000, lists:sum([proplists:get_value(count, S)
+                                                || {_Op, S} <- Ops]))
+              end || W <- [a, b, c, d, e, f]],
+             os:cmd("rm -rf " ++ Dir)
+     end}.
+
+-endif.
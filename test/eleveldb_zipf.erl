@@ -0,0 +1,75 @@
+%% -------------------------------------------------------------------
+%%
+%%  eleveldb: Erlang Wrapper for LevelDB (http://code.google.com/p/leveldb/)
+%%
+%% Copyright (c) 2010-2013 Basho Technologies, Inc. All Rights Reserved.
+%%
+%% This file is provided to you under the Apache License,
+%% Version 2.0 (the "License"); you may not use this file
+%% except in compliance with the License.  You may obtain
+%% a copy of the License at
+%%
+%%   http://www.apache.org/licenses/LICENSE-2.0
+%%
+%% Unless required by applicable law or agreed to in writing,
+%% software distributed under the License is distributed on an
+%% "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+%% KIND, either express or implied.  See the License for the
+%% specific language governing permissions and limitations
+%% under the License.
+%%
+%% -------------------------------------------------------------------
+
+%% Zipfian ranks 0 .. N-1 for the benchmark drivers, Gray et al.
+%% "Quickly Generating Billion-Record Synthetic Databases" as used by
+%% YCSB.  Draws come from the process's `random' state, so seeding
+%% that repeats the sequence.
+-module(eleveldb_zipf).
+
+-export([new/1,
+         new/2,
+         next/1]).
+
+%% YCSB's default skew
+-define(THETA, 0.99).
+
+-opaque zipf() :: {pos_integer(), float(), float(), float(), float()}.
+-export_type([zipf/0]).
+
+-spec new(pos_integer()) -> zipf().
+new(N) ->
+    new(N, ?THETA).
+
+-spec new(pos_integer(), float()) -> zipf().
+new(N, Theta) when is_integer(N), N >= 1 ->
+    ZetaN = zeta(N, Theta, 0.0),
+    Alpha = 1 / (1 - Theta),
+    {N, Theta, ZetaN, Alpha, eta(N, Theta, ZetaN)};
+new(N, _Theta) ->
+    erlang:error({zipf_needs_at_least_one_key, N}).
+
+-spec next(zipf()) -> non_neg_integer().
+next({N, Theta, ZetaN, Alpha, Eta}) ->
+    U = random:uniform(),
+    UZ = U * ZetaN,
+    if UZ < 1.0 ->
+            0;
+       UZ < 1.0 + math:pow(0.5, Theta) ->
+            1;
+       true ->
+            erlang:min(N - 1, trunc(N * math:pow(Eta * U - Eta + 1, Alpha)))
+    end.
+
+%% next/1 answers ranks 0 and 1 before using Eta, and with N =< 2
+%% those are the only ranks, so Eta (whose divisor is 0 at N = 2)
+%% is never needed.
+eta(N, _Theta, _ZetaN) when N =< 2 ->
+    0.0;
+eta(N, Theta, ZetaN) ->
+    Zeta2 = zeta(2, Theta, 0.0),
+    (1 - math:pow(2 / N, 1 - Theta)) / (1 - Zeta2 / ZetaN).
+
+zeta(0, _Theta, Sum) ->
+    Sum;
+zeta(I, Theta, Sum) ->
+    zeta(I - 1, Theta, Sum + 1 / math:pow(I, Theta)).